@@ -157,10 +157,28 @@ ZMQ_EXPORT const char *zmq_strerror (int errnum);
 /*  Context options                                                           */
 #define ZMQ_IO_THREADS  1
 #define ZMQ_MAX_SOCKETS 2
+#define ZMQ_MSG_POOL 3
+#define ZMQ_MSG_POOL_HITS 4
+#define ZMQ_MSG_POOL_MISSES 5
+#define ZMQ_MAILBOX_SPIN 6
+#define ZMQ_IO_BUSY_POLL 7
+#define ZMQ_IO_BUSY_POLL_THREADS 8
+#define ZMQ_IO_BUSY_POLL_SOCKETS 9
+#define ZMQ_IO_BUSY_ITERATIONS 10
+#define ZMQ_IO_IDLE_ITERATIONS 11
+#define ZMQ_IO_EDGE_TRIGGERED 12
+#define ZMQ_IO_BATCH_RELEASES 13
 
 /*  Default for new contexts                                                  */
 #define ZMQ_IO_THREADS_DFLT  1
 #define ZMQ_MAX_SOCKETS_DFLT 1024
+#define ZMQ_MSG_POOL_DFLT 0
+#define ZMQ_MAILBOX_SPIN_DFLT 0
+#define ZMQ_IO_BUSY_POLL_DFLT 0
+#define ZMQ_IO_BUSY_POLL_THREADS_DFLT 0
+#define ZMQ_IO_BUSY_POLL_SOCKETS_DFLT 0
+#define ZMQ_IO_EDGE_TRIGGERED_DFLT 0
+#define ZMQ_IO_BATCH_RELEASES_DFLT 0
 
 ZMQ_EXPORT void *zmq_ctx_new (void);
 ZMQ_EXPORT int zmq_ctx_destroy (void *context);
@@ -176,7 +194,16 @@ ZMQ_EXPORT int zmq_term (void *context);
 /*  0MQ message definition.                                                   */
 /******************************************************************************/
 
+/*  By default zmq_msg_t is 32 bytes long and messages of up to 29 bytes are  */
+/*  stored inline. When ZMQ_CACHELINE_MSG is defined, zmq_msg_t occupies a    */
+/*  whole 64-byte cache line and messages of up to 61 bytes are stored        */
+/*  inline. The two layouts are not binary compatible: the library and all    */
+/*  the applications using it have to be built with the same setting.        */
+#if defined ZMQ_CACHELINE_MSG
+typedef struct zmq_msg_t {unsigned char _ [64];} zmq_msg_t;
+#else
 typedef struct zmq_msg_t {unsigned char _ [32];} zmq_msg_t;
+#endif
 
 typedef void (zmq_free_fn) (void *data, void *hint);
 
@@ -186,6 +213,10 @@ ZMQ_EXPORT int zmq_msg_init_data (zmq_msg_t *msg, void *data,
     size_t size, zmq_free_fn *ffn, void *hint);
 ZMQ_EXPORT int zmq_msg_send (zmq_msg_t *msg, void *s, int flags);
 ZMQ_EXPORT int zmq_msg_recv (zmq_msg_t *msg, void *s, int flags);
+ZMQ_EXPORT int zmq_send_batch (void *s, zmq_msg_t *msgs, int count,
+    int flags);
+ZMQ_EXPORT int zmq_recv_batch (void *s, zmq_msg_t *msgs, int count,
+    int flags);
 ZMQ_EXPORT int zmq_msg_close (zmq_msg_t *msg);
 ZMQ_EXPORT int zmq_msg_move (zmq_msg_t *dest, zmq_msg_t *src);
 ZMQ_EXPORT int zmq_msg_copy (zmq_msg_t *dest, zmq_msg_t *src);
@@ -250,6 +281,11 @@ ZMQ_EXPORT int zmq_msg_set (zmq_msg_t *msg, int option, int optval);
 #define ZMQ_TCP_ACCEPT_FILTER 38
 #define ZMQ_DELAY_ATTACH_ON_CONNECT 39
 #define ZMQ_XPUB_VERBOSE 40
+#define ZMQ_XPUB_CONFLATE 41
+#define ZMQ_XPUB_CONFLATE_PREFIX 42
+#define ZMQ_XPUB_CACHE_SIZE 43
+#define ZMQ_XPUB_CACHE_PREFIX 44
+#define ZMQ_STATISTICS 45
 
 
 /*  Message options                                                           */
@@ -259,6 +295,17 @@ ZMQ_EXPORT int zmq_msg_set (zmq_msg_t *msg, int option, int optval);
 #define ZMQ_DONTWAIT 1
 #define ZMQ_SNDMORE 2
 
+/*  Indices of the counters returned by ZMQ_STATISTICS option. Each of them   */
+/*  is a uint64_t.                                                            */
+#define ZMQ_STAT_MSGS_IN 0
+#define ZMQ_STAT_BYTES_IN 1
+#define ZMQ_STAT_MSGS_OUT 2
+#define ZMQ_STAT_BYTES_OUT 3
+#define ZMQ_STAT_HWM_DROPS 4
+#define ZMQ_STAT_UNROUTABLE_DROPS 5
+#define ZMQ_STAT_RECONNECTS 6
+#define ZMQ_STAT_COUNT 7
+
 /*  Deprecated aliases                                                        */
 #define ZMQ_NOBLOCK ZMQ_DONTWAIT
 #define ZMQ_FAIL_UNROUTABLE ZMQ_ROUTER_MANDATORY
@@ -359,6 +406,13 @@ struct iovec;
 ZMQ_EXPORT int zmq_sendiov (void *s, struct iovec *iov, size_t count, int flags);
 ZMQ_EXPORT int zmq_recviov (void *s, struct iovec *iov, size_t *count, int flags);
 
+/*  Zero-copy variant of zmq_sendiov. Buffers are not copied; ownership of    */
+/*  every buffer passes to 0MQ and 'ffn' is invoked exactly once for each of  */
+/*  them (with the buffer address and 'hint') when it is no longer needed,    */
+/*  even if the call fails. 'ffn' may be NULL for buffers that live forever.  */
+ZMQ_EXPORT int zmq_sendiov_data (void *s, struct iovec *iov, size_t count,
+    int flags, zmq_free_fn *ffn, void *hint);
+
 /******************************************************************************/
 /*  I/O multiplexing.                                                         */
 /******************************************************************************/
@@ -381,9 +435,46 @@ typedef struct
 
 ZMQ_EXPORT int zmq_poll (zmq_pollitem_t *items, int nitems, long timeout);
 
+/*  Poller keeping the set of polled sockets and file descriptors between     */
+/*  the calls, so that waiting costs little when few of them are ready.       */
+
+typedef struct
+{
+    void *socket;
+#if defined _WIN32
+    SOCKET fd;
+#else
+    int fd;
+#endif
+    void *user_data;
+    short events;
+} zmq_poller_event_t;
+
+ZMQ_EXPORT void *zmq_poller_new (void);
+ZMQ_EXPORT int zmq_poller_destroy (void **poller);
+ZMQ_EXPORT int zmq_poller_add (void *poller, void *socket, void *user_data,
+    short events);
+ZMQ_EXPORT int zmq_poller_modify (void *poller, void *socket, short events);
+ZMQ_EXPORT int zmq_poller_remove (void *poller, void *socket);
+#if defined _WIN32
+ZMQ_EXPORT int zmq_poller_add_fd (void *poller, SOCKET fd, void *user_data,
+    short events);
+ZMQ_EXPORT int zmq_poller_modify_fd (void *poller, SOCKET fd, short events);
+ZMQ_EXPORT int zmq_poller_remove_fd (void *poller, SOCKET fd);
+#else
+ZMQ_EXPORT int zmq_poller_add_fd (void *poller, int fd, void *user_data,
+    short events);
+ZMQ_EXPORT int zmq_poller_modify_fd (void *poller, int fd, short events);
+ZMQ_EXPORT int zmq_poller_remove_fd (void *poller, int fd);
+#endif
+ZMQ_EXPORT int zmq_poller_wait_all (void *poller, zmq_poller_event_t *events,
+    int n_events, long timeout);
+
 /*  Built-in message proxy (3-way) */
 
 ZMQ_EXPORT int zmq_proxy (void *frontend, void *backend, void *capture);
+ZMQ_EXPORT int zmq_proxy_steerable (void *frontend, void *backend,
+    void *capture, void *control);
 
 /*  Deprecated aliases */
 #define ZMQ_STREAMER 1
@@ -0,0 +1,96 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+//  The library does not export its internals, so the mailbox is linked in
+//  from its object file, see Makefile.am. The commands are never processed,
+//  so they don't have to point to real objects.
+#include "../src/mailbox.hpp"
+#include "../src/thread.hpp"
+#include "../src/err.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+//  Measures how fast a single thread receives commands sent to its mailbox
+//  by a given number of threads at the same time, ie. the way an I/O thread
+//  is flooded with commands when lots of sockets are created or closed.
+
+static zmq::mailbox_t *mailbox;
+static int commands_per_thread;
+
+static void sender (void *)
+{
+    zmq::command_t cmd;
+    cmd.destination = NULL;
+    cmd.type = zmq::command_t::activate_read;
+    for (int i = 0; i != commands_per_thread; i++)
+        mailbox->send (cmd);
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 3) {
+        printf ("usage: command_storm <thread-count> <command-count>\n");
+        return 1;
+    }
+    int thread_count = atoi (argv [1]);
+    int command_count = atoi (argv [2]);
+    if (thread_count < 1 || command_count < thread_count) {
+        printf ("there must be at least one command per thread\n");
+        return 1;
+    }
+    commands_per_thread = command_count / thread_count;
+    command_count = commands_per_thread * thread_count;
+
+    mailbox = new zmq::mailbox_t;
+
+    void *watch = zmq_stopwatch_start ();
+
+    std::vector <zmq::thread_t> threads (thread_count);
+    for (int i = 0; i != thread_count; i++)
+        threads [i].start (sender, NULL);
+
+    zmq::command_t cmd;
+    for (int i = 0; i != command_count; i++) {
+        int rc = mailbox->recv (&cmd, -1);
+        zmq_assert (rc == 0);
+        zmq_assert (cmd.type == zmq::command_t::activate_read);
+    }
+
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    for (int i = 0; i != thread_count; i++)
+        threads [i].stop ();
+    delete mailbox;
+
+    unsigned long throughput = (unsigned long)
+        ((double) command_count / (double) elapsed * 1000000);
+
+    printf ("thread count: %d\n", thread_count);
+    printf ("command count: %d\n", command_count);
+    printf ("mean throughput: %d [cmd/s]\n", (int) throughput);
+
+    return 0;
+}
@@ -115,8 +115,9 @@ int main (int argc, char *argv [])
     unsigned long elapsed;
     double latency;
 
-    if (argc != 3) {
-        printf ("usage: inproc_lat <message-size> <roundtrip-count>\n");
+    if (argc != 3 && argc != 4) {
+        printf ("usage: inproc_lat <message-size> <roundtrip-count> "
+            "[mailbox-spin-ns]\n");
         return 1;
     }
 
@@ -129,6 +130,14 @@ int main (int argc, char *argv [])
         return -1;
     }
 
+    if (argc == 4) {
+        rc = zmq_ctx_set (ctx, ZMQ_MAILBOX_SPIN, atoi (argv [3]));
+        if (rc != 0) {
+            printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
     s = zmq_socket (ctx, ZMQ_REQ);
     if (!s) {
         printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
@@ -0,0 +1,153 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//  Same as local_thr, except that messages are received using
+//  zmq_recv_batch.
+
+#define MAX_BATCH_SIZE 1024
+
+int main (int argc, char *argv [])
+{
+    const char *bind_to;
+    int message_count;
+    size_t message_size;
+    int batch_size;
+    void *ctx;
+    void *s;
+    int rc;
+    int i;
+    int received;
+    zmq_msg_t msgs [MAX_BATCH_SIZE];
+    void *watch;
+    unsigned long elapsed;
+    unsigned long throughput;
+    double megabits;
+
+    if (argc != 5) {
+        printf ("usage: local_thr_batch <bind-to> <message-size> "
+            "<message-count> <batch-size>\n");
+        return 1;
+    }
+    bind_to = argv [1];
+    message_size = atoi (argv [2]);
+    message_count = atoi (argv [3]);
+    batch_size = atoi (argv [4]);
+    if (batch_size < 1 || batch_size > MAX_BATCH_SIZE) {
+        printf ("batch size must be between 1 and %d\n", MAX_BATCH_SIZE);
+        return 1;
+    }
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    s = zmq_socket (ctx, ZMQ_PULL);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_bind (s, bind_to);
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    for (i = 0; i != batch_size; i++) {
+        rc = zmq_msg_init (&msgs [i]);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    rc = zmq_recv_batch (s, msgs, 1, 0);
+    if (rc < 0) {
+        printf ("error in zmq_recv_batch: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    if (zmq_msg_size (&msgs [0]) != message_size) {
+        printf ("message of incorrect size received\n");
+        return -1;
+    }
+
+    watch = zmq_stopwatch_start ();
+
+    received = 1;
+    while (received != message_count) {
+        int count = message_count - received;
+        if (count > batch_size)
+            count = batch_size;
+        rc = zmq_recv_batch (s, msgs, count, 0);
+        if (rc < 0) {
+            printf ("error in zmq_recv_batch: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        for (i = 0; i != rc; i++) {
+            if (zmq_msg_size (&msgs [i]) != message_size) {
+                printf ("message of incorrect size received\n");
+                return -1;
+            }
+        }
+        received += rc;
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    for (i = 0; i != batch_size; i++) {
+        rc = zmq_msg_close (&msgs [i]);
+        if (rc != 0) {
+            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    throughput = (unsigned long)
+        ((double) message_count / (double) elapsed * 1000000);
+    megabits = (double) (throughput * message_size * 8) / 1000000;
+
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+    printf ("batch size: %d\n", (int) batch_size);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+    printf ("mean throughput: %.3f [Mb/s]\n", (double) megabits);
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
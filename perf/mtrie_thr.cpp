@@ -0,0 +1,129 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+//  The library does not export its internals, so the trie is linked in
+//  from its object file, see Makefile.am. The trie never looks inside the
+//  pipes, so the subscribers can be represented by arbitrary addresses.
+#include "../src/mtrie.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <algorithm>
+
+static unsigned long random_value (unsigned long *seed_)
+{
+    *seed_ = *seed_ * 1103515245 + 12345;
+    return (*seed_ >> 16) & 0x7fff;
+}
+
+//  Topics look like "quote.<market>.<instrument>". Subscriptions are either
+//  to a whole market or to a single instrument.
+static size_t make_topic (char *buf_, unsigned long *seed_, int topic_count_,
+    bool subscription_)
+{
+    int instrument = (int) ((random_value (seed_) << 15 |
+        random_value (seed_)) % topic_count_);
+    int market = instrument % 64;
+    if (subscription_ && random_value (seed_) % 100 == 0)
+        return sprintf (buf_, "quote.%d.", market);
+    return sprintf (buf_, "quote.%d.%d%s", market, instrument,
+        subscription_ ? "" : ".bid");
+}
+
+static void count_unsubscription (unsigned char *, size_t, void *arg_)
+{
+    (*(unsigned long*) arg_)++;
+}
+
+static void run (int subscription_count_, int subscriber_count_,
+    int message_count_)
+{
+    std::vector <char> subscribers (subscriber_count_);
+    unsigned long seed = 1;
+    char topic [64];
+
+    zmq::mtrie_t *subscriptions = new zmq::mtrie_t;
+
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != subscription_count_; i++) {
+        size_t size = make_topic (topic, &seed, subscription_count_, true);
+        int slot = (int) (random_value (&seed) % subscriber_count_);
+        subscriptions->add ((unsigned char*) topic, size,
+            (zmq::pipe_t*) &subscribers [slot], slot);
+    }
+    unsigned long add_time = zmq_stopwatch_stop (watch);
+
+    //  Match into a bitmap of slots, the way XPUB does it, and count the
+    //  subscribers each message would be sent to.
+    zmq::bitmap_t slots;
+    unsigned long matches = 0;
+    watch = zmq_stopwatch_start ();
+    for (int i = 0; i != message_count_; i++) {
+        size_t size = make_topic (topic, &seed, subscription_count_, false);
+        std::fill (slots.begin (), slots.end (), 0);
+        subscriptions->match ((unsigned char*) topic, size, slots);
+        for (zmq::bitmap_t::size_type j = 0; j != slots.size (); j++)
+            matches += zmq::bitmap_count (slots [j]);
+    }
+    unsigned long match_time = zmq_stopwatch_stop (watch);
+    if (match_time == 0)
+        match_time = 1;
+
+    unsigned long unsubscriptions = 0;
+    watch = zmq_stopwatch_start ();
+    for (int i = 0; i != subscriber_count_; i++)
+        subscriptions->rm ((zmq::pipe_t*) &subscribers [i],
+            count_unsubscription, &unsubscriptions);
+    unsigned long rm_time = zmq_stopwatch_stop (watch);
+
+    delete subscriptions;
+
+    printf ("%d subscriptions, %d subscribers:\n", subscription_count_,
+        subscriber_count_);
+    printf ("  add: %.3f [us/subscription]\n",
+        (double) add_time / subscription_count_);
+    printf ("  match: %d [msg/s], %d [matches/s]\n",
+        (int) ((double) message_count_ * 1000000 / match_time),
+        (int) ((double) matches * 1000000 / match_time));
+    printf ("  remove subscriber: %.3f [us]\n",
+        (double) rm_time / subscriber_count_);
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc > 4) {
+        printf ("usage: mtrie_thr [max-subscription-count] "
+            "[subscriber-count] [message-count]\n");
+        return 1;
+    }
+    int max_subscription_count = argc > 1 ? atoi (argv [1]) : 200000;
+    int subscriber_count = argc > 2 ? atoi (argv [2]) : 2000;
+    int message_count = argc > 3 ? atoi (argv [3]) : 1000000;
+
+    //  Grow the number of subscriptions tenfold at a time.
+    for (int count = 1000; count < max_subscription_count; count *= 10)
+        run (count, subscriber_count, message_count);
+    run (max_subscription_count, subscriber_count, message_count);
+
+    return 0;
+}
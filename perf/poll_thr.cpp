@@ -0,0 +1,128 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+//  Compares the cost of waiting for one ready socket among many idle ones
+//  with zmq_poll and with the persistent poller. Each iteration sends a
+//  message to the only active socket, waits for it and receives it.
+
+static void check (bool ok_, const char *what_)
+{
+    if (!ok_) {
+        printf ("error in %s: %s\n", what_, zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 3) {
+        printf ("usage: poll_thr <item-count> <iteration-count>\n");
+        return 1;
+    }
+    int item_count = atoi (argv [1]);
+    int iteration_count = atoi (argv [2]);
+    if (item_count < 1 || iteration_count < 1) {
+        printf ("item count and iteration count must be positive\n");
+        return 1;
+    }
+
+    void *ctx = zmq_ctx_new ();
+    check (ctx != NULL, "zmq_ctx_new");
+    int rc = zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, item_count + 16);
+    check (rc == 0, "zmq_ctx_set");
+
+    //  The first socket is the active one, the rest are never connected.
+    std::vector <void*> sockets (item_count);
+    for (int i = 0; i != item_count; i++) {
+        sockets [i] = zmq_socket (ctx, ZMQ_PAIR);
+        check (sockets [i] != NULL, "zmq_socket");
+    }
+    rc = zmq_bind (sockets [0], "inproc://poll_thr");
+    check (rc == 0, "zmq_bind");
+    void *sender = zmq_socket (ctx, ZMQ_PAIR);
+    check (sender != NULL, "zmq_socket");
+    rc = zmq_connect (sender, "inproc://poll_thr");
+    check (rc == 0, "zmq_connect");
+
+    std::vector <zmq_pollitem_t> items (item_count);
+    for (int i = 0; i != item_count; i++) {
+        items [i].socket = sockets [i];
+        items [i].fd = 0;
+        items [i].events = ZMQ_POLLIN;
+        items [i].revents = 0;
+    }
+
+    char buf [1];
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != iteration_count; i++) {
+        rc = zmq_send (sender, "A", 1, 0);
+        check (rc == 1, "zmq_send");
+        rc = zmq_poll (&items [0], item_count, -1);
+        check (rc == 1 && items [0].revents == ZMQ_POLLIN, "zmq_poll");
+        rc = zmq_recv (sockets [0], buf, sizeof (buf), 0);
+        check (rc == 1, "zmq_recv");
+    }
+    unsigned long poll_elapsed = zmq_stopwatch_stop (watch);
+
+    void *poller = zmq_poller_new ();
+    check (poller != NULL, "zmq_poller_new");
+    for (int i = 0; i != item_count; i++) {
+        rc = zmq_poller_add (poller, sockets [i], NULL, ZMQ_POLLIN);
+        check (rc == 0, "zmq_poller_add");
+    }
+
+    zmq_poller_event_t events [16];
+    watch = zmq_stopwatch_start ();
+    for (int i = 0; i != iteration_count; i++) {
+        rc = zmq_send (sender, "A", 1, 0);
+        check (rc == 1, "zmq_send");
+        rc = zmq_poller_wait_all (poller, events, 16, -1);
+        check (rc == 1 && events [0].socket == sockets [0],
+            "zmq_poller_wait_all");
+        rc = zmq_recv (sockets [0], buf, sizeof (buf), 0);
+        check (rc == 1, "zmq_recv");
+    }
+    unsigned long poller_elapsed = zmq_stopwatch_stop (watch);
+
+    printf ("item count: %d\n", item_count);
+    printf ("iteration count: %d\n", iteration_count);
+    printf ("zmq_poll: %.3f [us]\n",
+        (double) poll_elapsed / iteration_count);
+    printf ("zmq_poller_wait_all: %.3f [us]\n",
+        (double) poller_elapsed / iteration_count);
+
+    rc = zmq_poller_destroy (&poller);
+    check (rc == 0, "zmq_poller_destroy");
+    for (int i = 0; i != item_count; i++) {
+        rc = zmq_close (sockets [i]);
+        check (rc == 0, "zmq_close");
+    }
+    rc = zmq_close (sender);
+    check (rc == 0, "zmq_close");
+    rc = zmq_ctx_destroy (ctx);
+    check (rc == 0, "zmq_ctx_destroy");
+
+    return 0;
+}
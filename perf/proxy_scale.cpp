@@ -0,0 +1,235 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "../src/platform.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+//  Measures how the throughput of a ROUTER/DEALER broker scales when its
+//  traffic is split into shards. Each shard is a zmq_proxy running in its
+//  own thread between its own frontend and backend sockets, and gets its
+//  own client and its own echoing service. Clients keep a fixed number of
+//  requests in flight; the total request count is split among them.
+
+static const int window = 100;
+
+static void *ctx;
+static int message_size;
+static int requests_per_client;
+
+static void check (bool ok_, const char *what_)
+{
+    if (!ok_) {
+        printf ("error in %s: %s\n", what_, zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+static void *open_socket (int type_, const char *endpoint_, bool bind_)
+{
+    void *s = zmq_socket (ctx, type_);
+    check (s != NULL, "zmq_socket");
+    int linger = 0;
+    int rc = zmq_setsockopt (s, ZMQ_LINGER, &linger, sizeof (linger));
+    check (rc == 0, "zmq_setsockopt");
+    rc = bind_ ? zmq_bind (s, endpoint_) : zmq_connect (s, endpoint_);
+    check (rc == 0, bind_ ? "zmq_bind" : "zmq_connect");
+    return s;
+}
+
+#if defined ZMQ_HAVE_WINDOWS
+#define THREAD_FN unsigned int __stdcall
+typedef HANDLE thread_t;
+typedef unsigned int (__stdcall *thread_fn_t) (void*);
+#else
+#define THREAD_FN void *
+typedef pthread_t thread_t;
+typedef void *(*thread_fn_t) (void*);
+#endif
+
+static thread_t start_thread (thread_fn_t fn_, void *arg_)
+{
+    thread_t thread;
+#if defined ZMQ_HAVE_WINDOWS
+    thread = (HANDLE) _beginthreadex (NULL, 0, fn_, arg_, 0, NULL);
+    check (thread != 0, "_beginthreadex");
+#else
+    int rc = pthread_create (&thread, NULL, fn_, arg_);
+    check (rc == 0, "pthread_create");
+#endif
+    return thread;
+}
+
+static void join_thread (thread_t thread_)
+{
+#if defined ZMQ_HAVE_WINDOWS
+    DWORD rc = WaitForSingleObject (thread_, INFINITE);
+    check (rc != WAIT_FAILED, "WaitForSingleObject");
+    BOOL rc2 = CloseHandle (thread_);
+    check (rc2 != 0, "CloseHandle");
+#else
+    int rc = pthread_join (thread_, NULL);
+    check (rc == 0, "pthread_join");
+#endif
+}
+
+struct shard_t
+{
+    char frontend [32];
+    char backend [32];
+    void *frontend_socket;
+    void *backend_socket;
+    thread_t proxy;
+    thread_t client;
+    thread_t service;
+};
+
+static THREAD_FN client (void *arg_)
+{
+    shard_t *shard = (shard_t*) arg_;
+    void *s = open_socket (ZMQ_DEALER, shard->frontend, false);
+    zmq_msg_t msg;
+    int sent = 0;
+    for (int received = 0; received != requests_per_client; received++) {
+        while (sent != requests_per_client && sent - received != window) {
+            int rc = zmq_msg_init_size (&msg, message_size);
+            check (rc == 0, "zmq_msg_init_size");
+            rc = zmq_msg_send (&msg, s, 0);
+            check (rc >= 0, "zmq_msg_send");
+            sent++;
+        }
+        int rc = zmq_msg_init (&msg);
+        check (rc == 0, "zmq_msg_init");
+        rc = zmq_msg_recv (&msg, s, 0);
+        check (rc >= 0, "zmq_msg_recv");
+        zmq_msg_close (&msg);
+    }
+    zmq_close (s);
+    return 0;
+}
+
+//  Echoes the requests, envelope included, till the context is terminated.
+static THREAD_FN service (void *arg_)
+{
+    shard_t *shard = (shard_t*) arg_;
+    void *s = open_socket (ZMQ_DEALER, shard->backend, false);
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    check (rc == 0, "zmq_msg_init");
+    while (true) {
+        rc = zmq_msg_recv (&msg, s, 0);
+        if (rc < 0 && errno == ETERM)
+            break;
+        check (rc >= 0, "zmq_msg_recv");
+        rc = zmq_msg_send (&msg, s, zmq_msg_more (&msg) ? ZMQ_SNDMORE : 0);
+        check (rc >= 0, "zmq_msg_send");
+    }
+    zmq_msg_close (&msg);
+    zmq_close (s);
+    return 0;
+}
+
+static THREAD_FN proxy (void *arg_)
+{
+    shard_t *shard = (shard_t*) arg_;
+    int rc = zmq_proxy (shard->frontend_socket, shard->backend_socket, NULL);
+    check (rc == -1 && errno == ETERM, "zmq_proxy");
+    zmq_close (shard->frontend_socket);
+    zmq_close (shard->backend_socket);
+    return 0;
+}
+
+//  Returns the throughput in requests per second.
+static unsigned long run (int shard_count_, int message_count_)
+{
+    ctx = zmq_init (1);
+    check (ctx != NULL, "zmq_init");
+    requests_per_client = message_count_ / shard_count_;
+
+    std::vector <shard_t> shards (shard_count_);
+    for (int i = 0; i != shard_count_; i++) {
+        sprintf (shards [i].frontend, "inproc://frontend-%d", i);
+        sprintf (shards [i].backend, "inproc://backend-%d", i);
+        shards [i].frontend_socket =
+            open_socket (ZMQ_ROUTER, shards [i].frontend, true);
+        shards [i].backend_socket =
+            open_socket (ZMQ_DEALER, shards [i].backend, true);
+        shards [i].proxy = start_thread (proxy, &shards [i]);
+    }
+    for (int i = 0; i != shard_count_; i++)
+        shards [i].service = start_thread (service, &shards [i]);
+
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != shard_count_; i++)
+        shards [i].client = start_thread (client, &shards [i]);
+    for (int i = 0; i != shard_count_; i++)
+        join_thread (shards [i].client);
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    int rc = zmq_term (ctx);
+    check (rc == 0, "zmq_term");
+    for (int i = 0; i != shard_count_; i++) {
+        join_thread (shards [i].proxy);
+        join_thread (shards [i].service);
+    }
+
+    return (unsigned long) ((double) requests_per_client * shard_count_ /
+        (double) elapsed * 1000000);
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 4) {
+        printf ("usage: proxy_scale <max-shard-count> <message-size> "
+            "<message-count>\n");
+        return 1;
+    }
+    int max_shard_count = atoi (argv [1]);
+    message_size = atoi (argv [2]);
+    int message_count = atoi (argv [3]);
+    if (max_shard_count < 1 || message_count < max_shard_count) {
+        printf ("there must be at least one message per shard\n");
+        return 1;
+    }
+
+    printf ("message size: %d [B]\n", message_size);
+    printf ("message count: %d\n", message_count);
+    for (int shard_count = 1; shard_count <= max_shard_count;
+          shard_count *= 2) {
+        unsigned long throughput = run (shard_count, message_count);
+        printf ("shards: %d, mean throughput: %d [msg/s]\n", shard_count,
+            (int) throughput);
+    }
+
+    return 0;
+}
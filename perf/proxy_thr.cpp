@@ -0,0 +1,239 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../src/platform.hpp"
+
+#if defined ZMQ_HAVE_WINDOWS
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#endif
+
+//  Measures the throughput of a PUSH/PULL pipeline going through a proxy
+//  and the latency the proxy adds to a REQ/REP round trip. The proxy and
+//  the peers on the other side run in separate threads; all the transports
+//  are inproc so that only the proxy itself is measured.
+
+static void *ctx;
+static int message_size;
+static int message_count;
+static int roundtrip_count;
+
+static void check (bool ok_, const char *what_)
+{
+    if (!ok_) {
+        printf ("error in %s: %s\n", what_, zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+static void *open_socket (int type_, const char *endpoint_, bool bind_)
+{
+    void *s = zmq_socket (ctx, type_);
+    check (s != NULL, "zmq_socket");
+    int linger = 0;
+    int rc = zmq_setsockopt (s, ZMQ_LINGER, &linger, sizeof (linger));
+    check (rc == 0, "zmq_setsockopt");
+    rc = bind_ ? zmq_bind (s, endpoint_) : zmq_connect (s, endpoint_);
+    check (rc == 0, bind_ ? "zmq_bind" : "zmq_connect");
+    return s;
+}
+
+#if defined ZMQ_HAVE_WINDOWS
+#define THREAD_FN unsigned int __stdcall
+typedef HANDLE thread_t;
+typedef unsigned int (__stdcall *thread_fn_t) (void*);
+#else
+#define THREAD_FN void *
+typedef pthread_t thread_t;
+typedef void *(*thread_fn_t) (void*);
+#endif
+
+static thread_t start_thread (thread_fn_t fn_, void *arg_)
+{
+    thread_t thread;
+#if defined ZMQ_HAVE_WINDOWS
+    thread = (HANDLE) _beginthreadex (NULL, 0, fn_, arg_, 0, NULL);
+    check (thread != 0, "_beginthreadex");
+#else
+    int rc = pthread_create (&thread, NULL, fn_, arg_);
+    check (rc == 0, "pthread_create");
+#endif
+    return thread;
+}
+
+static void join_thread (thread_t thread_)
+{
+#if defined ZMQ_HAVE_WINDOWS
+    DWORD rc = WaitForSingleObject (thread_, INFINITE);
+    check (rc != WAIT_FAILED, "WaitForSingleObject");
+    BOOL rc2 = CloseHandle (thread_);
+    check (rc2 != 0, "CloseHandle");
+#else
+    int rc = pthread_join (thread_, NULL);
+    check (rc == 0, "pthread_join");
+#endif
+}
+
+//  Runs the proxy till the context is terminated.
+static THREAD_FN proxy (void *arg_)
+{
+    void **sockets = (void**) arg_;
+    int rc = zmq_proxy (sockets [0], sockets [1], NULL);
+    check (rc == -1 && errno == ETERM, "zmq_proxy");
+    zmq_close (sockets [0]);
+    zmq_close (sockets [1]);
+    return 0;
+}
+
+static THREAD_FN pusher (void *)
+{
+    void *s = open_socket (ZMQ_PUSH, "inproc://thr_frontend", false);
+    for (int i = 0; i != message_count; i++) {
+        zmq_msg_t msg;
+        int rc = zmq_msg_init_size (&msg, message_size);
+        check (rc == 0, "zmq_msg_init_size");
+        rc = zmq_sendmsg (s, &msg, 0);
+        check (rc >= 0, "zmq_sendmsg");
+    }
+    zmq_close (s);
+    return 0;
+}
+
+static THREAD_FN echo (void *arg_)
+{
+    void *s = open_socket (ZMQ_REP, (const char*) arg_, false);
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    check (rc == 0, "zmq_msg_init");
+    for (int i = 0; i != roundtrip_count; i++) {
+        rc = zmq_recvmsg (s, &msg, 0);
+        check (rc >= 0, "zmq_recvmsg");
+        rc = zmq_sendmsg (s, &msg, 0);
+        check (rc >= 0, "zmq_sendmsg");
+    }
+    zmq_msg_close (&msg);
+    zmq_close (s);
+    return 0;
+}
+
+//  Returns the mean round trip time in microseconds. If the endpoints are
+//  the same, the requester binds to it and the replier connects to it.
+//  Otherwise both connect to the proxy.
+static double measure_latency (const char *req_endpoint_,
+    const char *rep_endpoint_)
+{
+    bool direct = strcmp (req_endpoint_, rep_endpoint_) == 0;
+    void *s = open_socket (ZMQ_REQ, req_endpoint_, direct);
+    thread_t thread = start_thread (echo, (void*) rep_endpoint_);
+
+    zmq_msg_t msg;
+    int rc = zmq_msg_init_size (&msg, message_size);
+    check (rc == 0, "zmq_msg_init_size");
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != roundtrip_count; i++) {
+        rc = zmq_sendmsg (s, &msg, 0);
+        check (rc >= 0, "zmq_sendmsg");
+        rc = zmq_recvmsg (s, &msg, 0);
+        check (rc >= 0, "zmq_recvmsg");
+    }
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+
+    zmq_msg_close (&msg);
+    join_thread (thread);
+    zmq_close (s);
+    return (double) elapsed / roundtrip_count;
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc != 4) {
+        printf ("usage: proxy_thr <message-size> <message-count> "
+            "<roundtrip-count>\n");
+        return 1;
+    }
+    message_size = atoi (argv [1]);
+    message_count = atoi (argv [2]);
+    roundtrip_count = atoi (argv [3]);
+
+    ctx = zmq_init (1);
+    check (ctx != NULL, "zmq_init");
+
+    void *pipeline [2];
+    pipeline [0] = open_socket (ZMQ_PULL, "inproc://thr_frontend", true);
+    pipeline [1] = open_socket (ZMQ_PUSH, "inproc://thr_backend", true);
+    thread_t pipeline_thread = start_thread (proxy, pipeline);
+
+    void *broker [2];
+    broker [0] = open_socket (ZMQ_ROUTER, "inproc://lat_frontend", true);
+    broker [1] = open_socket (ZMQ_DEALER, "inproc://lat_backend", true);
+    thread_t broker_thread = start_thread (proxy, broker);
+
+    //  Throughput.
+    void *s = open_socket (ZMQ_PULL, "inproc://thr_backend", false);
+    thread_t pusher_thread = start_thread (pusher, NULL);
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    check (rc == 0, "zmq_msg_init");
+    rc = zmq_recvmsg (s, &msg, 0);
+    check (rc >= 0, "zmq_recvmsg");
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 1; i != message_count; i++) {
+        rc = zmq_recvmsg (s, &msg, 0);
+        check (rc >= 0, "zmq_recvmsg");
+    }
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+    zmq_msg_close (&msg);
+    join_thread (pusher_thread);
+    zmq_close (s);
+
+    //  Latency, without and with the proxy.
+    double direct = measure_latency ("inproc://lat_direct",
+        "inproc://lat_direct");
+    double proxied = measure_latency ("inproc://lat_frontend",
+        "inproc://lat_backend");
+
+    unsigned long throughput = (unsigned long)
+        ((double) (message_count - 1) / (double) elapsed * 1000000);
+    printf ("message size: %d [B]\n", message_size);
+    printf ("message count: %d\n", message_count);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+    printf ("roundtrip count: %d\n", roundtrip_count);
+    printf ("direct roundtrip: %.3f [us]\n", direct);
+    printf ("proxied roundtrip: %.3f [us]\n", proxied);
+
+    //  A round trip passes through the proxy twice.
+    printf ("added latency: %.3f [us]\n", (proxied - direct) / 2);
+
+    rc = zmq_term (ctx);
+    check (rc == 0, "zmq_term");
+    join_thread (pipeline_thread);
+    join_thread (broker_thread);
+    return 0;
+}
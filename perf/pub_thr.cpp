@@ -0,0 +1,192 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  Measures how fast a publisher fans messages out to a given number of
+//  subscribers. A single SUB socket connects to the publisher once per
+//  subscriber so that the number of subscribers is not limited by the
+//  number of file descriptors. Messages are published in batches; only
+//  the publishing is timed, the SUB socket drains the pipes between the
+//  batches.
+
+static const int batch_size = 100;
+
+int main (int argc, char *argv [])
+{
+    int subscriber_count;
+    int message_size;
+    int message_count;
+    void *ctx;
+    void *pub;
+    void *sub;
+    int rc;
+    int i;
+    int hwm = 0;
+    int linger = 0;
+    int verbose = 1;
+    void *body;
+    void *watch;
+    unsigned long elapsed = 0;
+    unsigned long throughput;
+
+    if (argc != 4) {
+        printf ("usage: pub_thr <subscriber-count> <message-size> "
+            "<message-count>\n");
+        return 1;
+    }
+    subscriber_count = atoi (argv [1]);
+    message_size = atoi (argv [2]);
+    message_count = atoi (argv [3]);
+    if (subscriber_count < 1 || message_size < 1) {
+        printf ("subscriber count and message size must be positive\n");
+        return 1;
+    }
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    //  XPUB socket is used so that we can find out when all the
+    //  subscriptions have arrived.
+    pub = zmq_socket (ctx, ZMQ_XPUB);
+    if (!pub) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    if (rc == 0)
+        rc = zmq_setsockopt (pub, ZMQ_LINGER, &linger, sizeof (linger));
+    if (rc == 0)
+        rc = zmq_setsockopt (pub, ZMQ_XPUB_VERBOSE, &verbose,
+            sizeof (verbose));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_bind (pub, "inproc://pub_thr");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    sub = zmq_socket (ctx, ZMQ_SUB);
+    if (!sub) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    if (rc == 0)
+        rc = zmq_setsockopt (sub, ZMQ_LINGER, &linger, sizeof (linger));
+    if (rc == 0)
+        rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    for (i = 0; i != subscriber_count; i++) {
+        rc = zmq_connect (sub, "inproc://pub_thr");
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    //  Wait till the publisher gets the subscription from each subscriber.
+    for (i = 0; i != subscriber_count; i++) {
+        char subscription [1];
+        rc = zmq_recv (pub, subscription, sizeof (subscription), 0);
+        if (rc != 1) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    body = malloc (message_size);
+    if (!body) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+    memset (body, 0, message_size);
+
+    for (i = 0; i < message_count; i += batch_size) {
+        int batch = message_count - i < batch_size ?
+            message_count - i : batch_size;
+        int j;
+
+        watch = zmq_stopwatch_start ();
+        for (j = 0; j != batch; j++) {
+            rc = zmq_send (pub, body, message_size, 0);
+            if (rc != message_size) {
+                printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+        elapsed += zmq_stopwatch_stop (watch);
+
+        for (j = 0; j != batch * subscriber_count; j++) {
+            rc = zmq_recv (sub, body, message_size, 0);
+            if (rc != message_size) {
+                printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+    }
+
+    if (elapsed == 0)
+        elapsed = 1;
+
+    throughput = (unsigned long)
+        ((double) message_count / (double) elapsed * 1000000);
+
+    printf ("subscriber count: %d\n", subscriber_count);
+    printf ("message size: %d [B]\n", message_size);
+    printf ("message count: %d\n", message_count);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+    printf ("mean fan-out: %d [msg/s]\n",
+        (int) ((double) throughput * subscriber_count));
+
+    free (body);
+
+    rc = zmq_close (sub);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_close (pub);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,151 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  Same as remote_thr, except that messages are sent using zmq_send_batch.
+
+#define MAX_BATCH_SIZE 1024
+
+int main (int argc, char *argv [])
+{
+    const char *connect_to;
+    int message_count;
+    int message_size;
+    int batch_size;
+    void *ctx;
+    void *s;
+    int rc;
+    int i;
+    int sent;
+    int filled;
+    zmq_msg_t msgs [MAX_BATCH_SIZE];
+
+    if (argc != 5) {
+        printf ("usage: remote_thr_batch <connect-to> <message-size> "
+            "<message-count> <batch-size>\n");
+        return 1;
+    }
+    connect_to = argv [1];
+    message_size = atoi (argv [2]);
+    message_count = atoi (argv [3]);
+    batch_size = atoi (argv [4]);
+    if (batch_size < 1 || batch_size > MAX_BATCH_SIZE) {
+        printf ("batch size must be between 1 and %d\n", MAX_BATCH_SIZE);
+        return 1;
+    }
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    s = zmq_socket (ctx, ZMQ_PUSH);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    //  Add your socket options here.
+    //  For example ZMQ_RATE, ZMQ_RECOVERY_IVL and ZMQ_MCAST_LOOP for PGM.
+
+    rc = zmq_connect (s, connect_to);
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    for (i = 0; i != batch_size; i++) {
+        rc = zmq_msg_init (&msgs [i]);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    //  The messages that were sent are nullified by zmq_send_batch, the
+    //  rest of the batch stays in place and is sent in the next round.
+    sent = 0;
+    filled = 0;
+    while (sent != message_count) {
+        int count = message_count - sent;
+        if (count > batch_size)
+            count = batch_size;
+        for (; filled != count; filled++) {
+            rc = zmq_msg_close (&msgs [filled]);
+            if (rc != 0) {
+                printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+            rc = zmq_msg_init_size (&msgs [filled], message_size);
+            if (rc != 0) {
+                printf ("error in zmq_msg_init_size: %s\n",
+                    zmq_strerror (errno));
+                return -1;
+            }
+#if defined ZMQ_MAKE_VALGRIND_HAPPY
+            memset (zmq_msg_data (&msgs [filled]), 0, message_size);
+#endif
+        }
+
+        rc = zmq_send_batch (s, msgs, count, 0);
+        if (rc < 0) {
+            printf ("error in zmq_send_batch: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        sent += rc;
+
+        //  Move the unsent messages to the front of the array. The slots
+        //  behind them are either empty or hold stale copies, so they are
+        //  re-initialised rather than closed.
+        if (rc != count) {
+            memmove (msgs, msgs + rc, (count - rc) * sizeof (zmq_msg_t));
+            for (i = count - rc; i != count; i++)
+                zmq_msg_init (&msgs [i]);
+        }
+        filled = count - rc;
+    }
+
+    for (i = 0; i != batch_size; i++) {
+        rc = zmq_msg_close (&msgs [i]);
+        if (rc != 0) {
+            printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  Measures how fast a ROUTER socket routes messages to a given number of
+//  peers. A single DEALER socket connects to the ROUTER once per peer,
+//  using a different identity each time, so that the number of peers is
+//  not limited by the number of file descriptors. The DEALER doesn't read
+//  the messages; they are queued in the pipes.
+
+static void make_identity (unsigned char *identity_, int identity_size_,
+    int peer_)
+{
+    char buf [16];
+    int len = sprintf (buf, "%d", peer_);
+    memset (identity_, 'p', identity_size_);
+    memcpy (identity_ + identity_size_ - len, buf, len);
+}
+
+int main (int argc, char *argv [])
+{
+    int peer_count;
+    int identity_size;
+    int message_size;
+    int message_count;
+    void *ctx;
+    void *router;
+    void *dealer;
+    int rc;
+    int i;
+    int hwm = 0;
+    int linger = 0;
+    int mandatory = 1;
+    unsigned char identity [255];
+    void *body;
+    void *watch;
+    unsigned long elapsed;
+    unsigned long throughput;
+
+    if (argc != 5) {
+        printf ("usage: router_thr <peer-count> <identity-size> "
+            "<message-size> <message-count>\n");
+        return 1;
+    }
+    peer_count = atoi (argv [1]);
+    identity_size = atoi (argv [2]);
+    message_size = atoi (argv [3]);
+    message_count = atoi (argv [4]);
+    if (identity_size < 10 || identity_size > 255) {
+        printf ("identity size must be between 10 and 255\n");
+        return 1;
+    }
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    router = zmq_socket (ctx, ZMQ_ROUTER);
+    if (!router) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_setsockopt (router, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    if (rc == 0)
+        rc = zmq_setsockopt (router, ZMQ_LINGER, &linger, sizeof (linger));
+    if (rc == 0)
+        rc = zmq_setsockopt (router, ZMQ_ROUTER_MANDATORY, &mandatory,
+            sizeof (mandatory));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_bind (router, "inproc://router_thr");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    dealer = zmq_socket (ctx, ZMQ_DEALER);
+    if (!dealer) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_setsockopt (dealer, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    if (rc == 0)
+        rc = zmq_setsockopt (dealer, ZMQ_LINGER, &linger, sizeof (linger));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    for (i = 0; i != peer_count; i++) {
+        make_identity (identity, identity_size, i);
+        rc = zmq_setsockopt (dealer, ZMQ_IDENTITY, identity, identity_size);
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_connect (dealer, "inproc://router_thr");
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    //  Wait till the ROUTER knows all the peers, i.e. till a message can be
+    //  routed to each of them.
+    for (i = 0; i != peer_count; i++) {
+        make_identity (identity, identity_size, i);
+        while (true) {
+            rc = zmq_send (router, identity, identity_size, ZMQ_SNDMORE);
+            if (rc == identity_size)
+                break;
+            if (errno != EHOSTUNREACH) {
+                printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+            zmq_sleep (0);
+        }
+        rc = zmq_send (router, NULL, 0, 0);
+        if (rc != 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    body = malloc (message_size ? message_size : 1);
+    if (!body) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+    memset (body, 0, message_size);
+
+    watch = zmq_stopwatch_start ();
+
+    for (i = 0; i != message_count; i++) {
+        make_identity (identity, identity_size, i % peer_count);
+        rc = zmq_send (router, identity, identity_size, ZMQ_SNDMORE);
+        if (rc != identity_size) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_send (router, body, message_size, 0);
+        if (rc != message_size) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    throughput = (unsigned long)
+        ((double) message_count / (double) elapsed * 1000000);
+
+    printf ("peer count: %d\n", peer_count);
+    printf ("identity size: %d [B]\n", identity_size);
+    printf ("message size: %d [B]\n", message_size);
+    printf ("message count: %d\n", message_count);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+
+    free (body);
+
+    rc = zmq_close (dealer);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_close (router);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include "../include/zmq_utils.h"
+#include "../src/i_poll_events.hpp"
+
+//  The library does not export its internals, so the timer wheel is linked
+//  in from its object file, see Makefile.am.
+#include "../src/timer_wheel.hpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <map>
+#include <vector>
+#include <algorithm>
+
+//  Object counting the timer events it gets.
+struct sink_t : public zmq::i_poll_events
+{
+    sink_t () : fired (0) {}
+    void in_event () {}
+    void out_event () {}
+    void timer_event (int) { fired++; }
+    unsigned long fired;
+};
+
+//  The way timers used to be kept: a multimap sorted by expiration, with
+//  cancellation scanning the map for the sink and ID.
+class multimap_timers_t
+{
+public:
+
+    void add (uint64_t now_, int timeout_, zmq::i_poll_events *sink_, int id_)
+    {
+        timer_info_t info = {sink_, id_};
+        timers.insert (timers_t::value_type (now_ + timeout_, info));
+    }
+
+    bool cancel (zmq::i_poll_events *sink_, int id_)
+    {
+        for (timers_t::iterator it = timers.begin (); it != timers.end (); ++it)
+            if (it->second.sink == sink_ && it->second.id == id_) {
+                timers.erase (it);
+                return true;
+            }
+        return false;
+    }
+
+    uint64_t execute (uint64_t now_)
+    {
+        timers_t::iterator it = timers.begin ();
+        while (it != timers.end ()) {
+            if (it->first > now_)
+                return it->first - now_;
+            it->second.sink->timer_event (it->second.id);
+            timers_t::iterator o = it;
+            ++it;
+            timers.erase (o);
+        }
+        return 0;
+    }
+
+    bool empty ()
+    {
+        return timers.empty ();
+    }
+
+private:
+
+    struct timer_info_t
+    {
+        zmq::i_poll_events *sink;
+        int id;
+    };
+    typedef std::multimap <uint64_t, timer_info_t> timers_t;
+    timers_t timers;
+};
+
+static unsigned long random_value (unsigned long *seed_)
+{
+    *seed_ = *seed_ * 1103515245 + 12345;
+    return (*seed_ >> 16) & 0x7fff;
+}
+
+//  Adds timer_count_ timers with timeouts of 1 to 60 seconds, like those of
+//  reconnecting connecters and lingering sessions, and cancels them in
+//  random order. Then adds the same number of timers expiring within one
+//  second and executes them, advancing the time by one millisecond at once.
+template <typename T> static void run (const char *name_, int timer_count_)
+{
+    std::vector <sink_t> sinks (timer_count_);
+    std::vector <int> order (timer_count_);
+    unsigned long seed = 1;
+    for (int i = 0; i != timer_count_; i++)
+        order [i] = i;
+    for (int i = timer_count_ - 1; i > 0; i--)
+        std::swap (order [i],
+            order [(random_value (&seed) << 15 | random_value (&seed)) % (i + 1)]);
+
+    T *timers = new T;
+    uint64_t now = 1000000;
+
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != timer_count_; i++)
+        timers->add (now, 1000 + (int) random_value (&seed) * 2, &sinks [i], 1);
+    unsigned long add_time = zmq_stopwatch_stop (watch);
+
+    watch = zmq_stopwatch_start ();
+    for (int i = 0; i != timer_count_; i++) {
+        bool found = timers->cancel (&sinks [order [i]], 1);
+        if (!found) {
+            printf ("error: timer not found\n");
+            exit (1);
+        }
+    }
+    unsigned long cancel_time = zmq_stopwatch_stop (watch);
+
+    for (int i = 0; i != timer_count_; i++)
+        timers->add (now, 1 + (int) random_value (&seed) % 1000, &sinks [i], 2);
+    watch = zmq_stopwatch_start ();
+    while (!timers->empty ())
+        timers->execute (++now);
+    unsigned long execute_time = zmq_stopwatch_stop (watch);
+
+    unsigned long fired = 0;
+    for (int i = 0; i != timer_count_; i++)
+        fired += sinks [i].fired;
+    if (fired != (unsigned long) timer_count_) {
+        printf ("error: %lu timers fired, %d expected\n", fired, timer_count_);
+        exit (1);
+    }
+    delete timers;
+
+    printf ("%s, %d timers:\n", name_, timer_count_);
+    printf ("  add: %.3f [us/timer]\n", (double) add_time / timer_count_);
+    printf ("  cancel: %.3f [us/timer]\n", (double) cancel_time / timer_count_);
+    printf ("  expire: %.3f [us/timer]\n",
+        (double) execute_time / timer_count_);
+}
+
+int main (int argc, char *argv [])
+{
+    if (argc > 3) {
+        printf ("usage: timer_thr [timer-count] [multimap-timer-count]\n");
+        return 1;
+    }
+    int timer_count = argc > 1 ? atoi (argv [1]) : 100000;
+
+    //  Cancelling timers kept in the multimap is O(n), so it gets fewer
+    //  timers by default.
+    int multimap_timer_count = argc > 2 ? atoi (argv [2]) : 10000;
+
+    run <zmq::timer_wheel_t> ("timer wheel", timer_count);
+    if (multimap_timer_count > 0)
+        run <multimap_timers_t> ("multimap", multimap_timer_count);
+
+    return 0;
+}
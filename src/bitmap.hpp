@@ -0,0 +1,87 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_BITMAP_HPP_INCLUDED__
+#define __ZMQ_BITMAP_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Set of small non-negative integers, such as pipe slots, 64 of them
+    //  per word. The bitmap grows as needed when bits are set.
+    typedef std::vector <uint64_t> bitmap_t;
+
+    inline void bitmap_set (bitmap_t &bitmap_, int bit_)
+    {
+        const size_t word = bit_ / 64;
+        if (word >= bitmap_.size ())
+            bitmap_.resize (word + 1, 0);
+        bitmap_ [word] |= (uint64_t) 1 << (bit_ % 64);
+    }
+
+    inline void bitmap_reset (bitmap_t &bitmap_, int bit_)
+    {
+        const size_t word = bit_ / 64;
+        if (word < bitmap_.size ())
+            bitmap_ [word] &= ~((uint64_t) 1 << (bit_ % 64));
+    }
+
+    //  Adds all the bits of src_ to dest_.
+    inline void bitmap_or (bitmap_t &dest_, const bitmap_t &src_)
+    {
+        if (dest_.size () < src_.size ())
+            dest_.resize (src_.size (), 0);
+        for (size_t i = 0; i != src_.size (); i++)
+            dest_ [i] |= src_ [i];
+    }
+
+    //  Number of bits set in the word.
+    inline int bitmap_count (uint64_t word_)
+    {
+#if defined __GNUC__
+        return __builtin_popcountll (word_);
+#else
+        int count = 0;
+        for (; word_; word_ &= word_ - 1)
+            count++;
+        return count;
+#endif
+    }
+
+    //  Index of the lowest bit set in the word. The word must not be zero.
+    inline int bitmap_lowest (uint64_t word_)
+    {
+#if defined __GNUC__
+        return __builtin_ctzll (word_);
+#else
+        int index = 0;
+        for (; !(word_ & 1); word_ >>= 1)
+            index++;
+        return index;
+#endif
+    }
+
+}
+
+#endif
@@ -37,6 +37,10 @@ namespace zmq
         //  Commands in pipe per allocation event.
         command_pipe_granularity = 16,
 
+        //  Number of attempts to read a command between two checks of the
+        //  clock when the mailbox spins before going to sleep.
+        mailbox_spin_checks = 64,
+
         //  Determines how often does socket poll for new commands when it
         //  still has unprocessed messages to handle. Thus, if it is set to 100,
         //  socket will process 100 inbound messages before doing the poll.
@@ -45,6 +49,12 @@ namespace zmq
         //  real-time behaviour (less latency peaks).
         inbound_poll_rate = 100,
 
+        //  Maximal number of messages the proxy moves in one direction before
+        //  it gives the other direction a chance. Higher values mean less
+        //  polling under load, lower ones a fairer share of the proxy for
+        //  the replies and the requests.
+        proxy_batch_size = 256,
+
         //  Maximal batching size for engines with receiving functionality.
         //  So, if there are 10 messages that fit into the batch size, all of
         //  them may be read by a single 'recv' system call, thus avoiding
@@ -57,6 +67,28 @@ namespace zmq
         //  unnecessary network stack traversals.
         out_batch_size = 8192,
 
+        //  Maximal number of bytes each thread keeps cached in the message
+        //  pool for every block size class.
+        msg_pool_cache_size = 262144,
+
+        //  Maximal number of distinct message contents a thread batching
+        //  its releases keeps deferred decrements for.
+        release_batch_size = 16,
+
+        //  Maximal number of slices the engines pass to a single writev
+        //  call.
+        out_batch_iov = 64,
+
+        //  Message bodies of at least this size are passed to writev
+        //  directly rather than being copied into the batch buffer.
+        out_zero_copy_threshold = 1024,
+
+        //  SUB and XSUB sockets match messages using a hash table rather
+        //  than the trie if there are at least this many subscriptions and
+        //  they are of at most this many distinct lengths.
+        prefix_matcher_min_subscriptions = 256,
+        prefix_matcher_max_lengths = 4,
+
         //  Maximal delta between high and low watermark.
         max_wm_delta = 1024,
 
@@ -0,0 +1,103 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "conflate.hpp"
+#include "pipe.hpp"
+#include "err.hpp"
+
+zmq::conflate_t::conflate_t (size_t prefix_, size_t limit_) :
+    current (NULL),
+    prefix (prefix_),
+    limit (limit_)
+{
+}
+
+zmq::conflate_t::~conflate_t ()
+{
+    for (topics_t::iterator it = topics.begin (); it != topics.end (); ++it)
+        close (it->second);
+}
+
+bool zmq::conflate_t::store (msg_t *msg_, bool first_)
+{
+    if (first_) {
+        size_t size = msg_->size ();
+        if (prefix && size > prefix)
+            size = prefix;
+        blob_t topic ((unsigned char*) msg_->data (), size);
+
+        //  Replace the message stored for the topic, if any. A new topic
+        //  is only taken while there's room for it.
+        topics_t::iterator it = topics.find (topic);
+        if (it == topics.end ()) {
+            if (limit && topics.size () >= limit) {
+                current = NULL;
+                return false;
+            }
+            it = topics.insert (topics_t::value_type (topic, parts_t ())).first;
+        }
+        current = &it->second;
+        close (*current);
+    }
+    else
+    if (!current)
+        return false;
+
+    current->push_back (*msg_);
+    if (!(msg_->flags () & msg_t::more))
+        current = NULL;
+    return true;
+}
+
+bool zmq::conflate_t::empty ()
+{
+    return topics.empty ();
+}
+
+bool zmq::conflate_t::write (pipe_t *pipe_)
+{
+    topics_t::iterator it = topics.begin ();
+    while (it != topics.end ()) {
+
+        //  Messages still being stored are left for later.
+        if (&it->second == current) {
+            ++it;
+            continue;
+        }
+
+        //  Once the first part gets in, so do the rest.
+        if (!pipe_->check_write ())
+            return false;
+        for (parts_t::size_type i = 0; i != it->second.size (); i++) {
+            bool ok = pipe_->write (&it->second [i]);
+            zmq_assert (ok);
+        }
+        topics.erase (it++);
+    }
+    return current == NULL;
+}
+
+void zmq::conflate_t::close (parts_t &parts_)
+{
+    for (parts_t::size_type i = 0; i != parts_.size (); i++) {
+        int rc = parts_ [i].close ();
+        errno_assert (rc == 0);
+    }
+    parts_.clear ();
+}
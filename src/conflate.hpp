@@ -0,0 +1,91 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_CONFLATE_HPP_INCLUDED__
+#define __ZMQ_CONFLATE_HPP_INCLUDED__
+
+#include <map>
+#include <vector>
+#include <stddef.h>
+
+#include "blob.hpp"
+#include "msg.hpp"
+
+namespace zmq
+{
+
+    class pipe_t;
+
+    //  Holds the messages that couldn't be written to a pipe because it
+    //  has reached its high watermark. Only the latest message is kept for
+    //  each topic, the topic being the leading bytes of its first part.
+    //  Messages are held in the byte order of their topics, not in the
+    //  order they arrived in.
+
+    class conflate_t
+    {
+    public:
+
+        //  If prefix_ is 0, the whole first part is the topic. At most
+        //  limit_ topics are held, or any number of them if limit_ is 0.
+        conflate_t (size_t prefix_, size_t limit_);
+        ~conflate_t ();
+
+        //  Stores a part of a message, taking over the reference held by
+        //  msg_. The first part of a message replaces any message stored
+        //  earlier for the same topic. The following parts are only stored
+        //  if the first part was. A message with a new topic is not stored
+        //  once the limit of topics is reached. Returns false if the part
+        //  was not stored.
+        bool store (zmq::msg_t *msg_, bool first_);
+
+        //  Returns true if there are no messages held.
+        bool empty ();
+
+        //  Writes the held messages to the pipe until its high watermark is
+        //  reached. Returns false if some messages are still held. The pipe
+        //  is not flushed.
+        bool write (zmq::pipe_t *pipe_);
+
+    private:
+
+        //  Drops all the parts of the message.
+        static void close (std::vector <msg_t> &parts_);
+
+        //  Parts of the latest message for each topic.
+        typedef std::vector <msg_t> parts_t;
+        typedef std::map <blob_t, parts_t> topics_t;
+        topics_t topics;
+
+        //  Message being stored at the moment, NULL if there's none.
+        parts_t *current;
+
+        //  Number of leading bytes of the first part forming the topic.
+        size_t prefix;
+
+        //  Maximum number of topics held, 0 if unlimited.
+        size_t limit;
+
+        conflate_t (const conflate_t&);
+        const conflate_t &operator = (const conflate_t&);
+    };
+
+}
+
+#endif
@@ -28,6 +28,7 @@
 
 #include <new>
 #include <string.h>
+#include <limits.h>
 
 #include "ctx.hpp"
 #include "socket_base.hpp"
@@ -36,6 +37,7 @@
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
+#include "msg_pool.hpp"
 
 zmq::ctx_t::ctx_t () :
     tag (0xabadcafe),
@@ -45,7 +47,14 @@ zmq::ctx_t::ctx_t () :
     slot_count (0),
     slots (NULL),
     max_sockets (ZMQ_MAX_SOCKETS_DFLT),
-    io_thread_count (ZMQ_IO_THREADS_DFLT)
+    io_thread_count (ZMQ_IO_THREADS_DFLT),
+    msg_pool (ZMQ_MSG_POOL_DFLT),
+    mailbox_spin (ZMQ_MAILBOX_SPIN_DFLT),
+    io_busy_poll (ZMQ_IO_BUSY_POLL_DFLT),
+    io_busy_poll_threads (ZMQ_IO_BUSY_POLL_THREADS_DFLT),
+    io_busy_poll_sockets (ZMQ_IO_BUSY_POLL_SOCKETS_DFLT),
+    io_edge_triggered (ZMQ_IO_EDGE_TRIGGERED_DFLT),
+    io_batch_releases (ZMQ_IO_BATCH_RELEASES_DFLT)
 {
 }
 
@@ -72,6 +81,11 @@ zmq::ctx_t::~ctx_t ()
     if (reaper)
         delete reaper;
 
+    //  Stop using the message pool. Blocks cached by the threads are kept
+    //  for other contexts to reuse.
+    if (msg_pool)
+        msg_pool_disable ();
+
     //  Deallocate the array of mailboxes. No special work is
     //  needed as mailboxes themselves were deallocated with their
     //  corresponding io_thread/socket objects.
@@ -139,6 +153,54 @@ int zmq::ctx_t::set (int option_, int optval_)
         io_thread_count = optval_;
         opt_sync.unlock ();
     }
+    else
+    if (option_ == ZMQ_MSG_POOL && optval_ >= 0) {
+        opt_sync.lock ();
+        bool enable = optval_ != 0;
+        if (enable && !msg_pool)
+            msg_pool_enable ();
+        else
+        if (!enable && msg_pool)
+            msg_pool_disable ();
+        msg_pool = enable;
+        opt_sync.unlock ();
+    }
+    else
+    if (option_ == ZMQ_MAILBOX_SPIN && optval_ >= 0) {
+        opt_sync.lock ();
+        mailbox_spin = optval_;
+        opt_sync.unlock ();
+    }
+    else
+    if (option_ == ZMQ_IO_BUSY_POLL && optval_ >= 0) {
+        opt_sync.lock ();
+        io_busy_poll = optval_;
+        opt_sync.unlock ();
+    }
+    else
+    if (option_ == ZMQ_IO_BUSY_POLL_THREADS && optval_ >= 0) {
+        opt_sync.lock ();
+        io_busy_poll_threads = optval_;
+        opt_sync.unlock ();
+    }
+    else
+    if (option_ == ZMQ_IO_BUSY_POLL_SOCKETS && optval_ >= 0) {
+        opt_sync.lock ();
+        io_busy_poll_sockets = optval_ != 0;
+        opt_sync.unlock ();
+    }
+    else
+    if (option_ == ZMQ_IO_EDGE_TRIGGERED && optval_ >= 0) {
+        opt_sync.lock ();
+        io_edge_triggered = optval_ != 0;
+        opt_sync.unlock ();
+    }
+    else
+    if (option_ == ZMQ_IO_BATCH_RELEASES && optval_ >= 0) {
+        opt_sync.lock ();
+        io_batch_releases = optval_ != 0;
+        opt_sync.unlock ();
+    }
     else {
         errno = EINVAL;
         rc = -1;
@@ -154,6 +216,48 @@ int zmq::ctx_t::get (int option_)
     else
     if (option_ == ZMQ_IO_THREADS)
         rc = io_thread_count;
+    else
+    if (option_ == ZMQ_MSG_POOL)
+        rc = msg_pool ? 1 : 0;
+    else
+    if (option_ == ZMQ_MSG_POOL_HITS || option_ == ZMQ_MSG_POOL_MISSES) {
+        uint32_t hits, misses;
+        msg_pool_stats (&hits, &misses);
+        uint32_t value = option_ == ZMQ_MSG_POOL_HITS ? hits : misses;
+        rc = (int) (value & INT_MAX);
+    }
+    else
+    if (option_ == ZMQ_MAILBOX_SPIN)
+        rc = mailbox_spin;
+    else
+    if (option_ == ZMQ_IO_BUSY_POLL)
+        rc = io_busy_poll;
+    else
+    if (option_ == ZMQ_IO_BUSY_POLL_THREADS)
+        rc = io_busy_poll_threads;
+    else
+    if (option_ == ZMQ_IO_BUSY_POLL_SOCKETS)
+        rc = io_busy_poll_sockets ? 1 : 0;
+    else
+    if (option_ == ZMQ_IO_EDGE_TRIGGERED)
+        rc = io_edge_triggered ? 1 : 0;
+    else
+    if (option_ == ZMQ_IO_BATCH_RELEASES)
+        rc = io_batch_releases ? 1 : 0;
+    else
+    if (option_ == ZMQ_IO_BUSY_ITERATIONS ||
+          option_ == ZMQ_IO_IDLE_ITERATIONS) {
+        uint32_t value = 0;
+        slot_sync.lock ();
+        for (io_threads_t::size_type i = 0; i != io_threads.size (); i++) {
+            poller_t *poller = io_threads [i]->get_poller ();
+            value += option_ == ZMQ_IO_BUSY_ITERATIONS ?
+                poller->get_busy_iterations () :
+                poller->get_idle_iterations ();
+        }
+        slot_sync.unlock ();
+        rc = (int) (value & INT_MAX);
+    }
     else {
         errno = EINVAL;
         rc = -1;
@@ -172,6 +276,11 @@ zmq::socket_base_t *zmq::ctx_t::create_socket (int type_)
         opt_sync.lock ();
         int mazmq = max_sockets;
         int ios = io_thread_count;
+        int busy_poll = io_busy_poll;
+        int busy_poll_threads = io_busy_poll_threads;
+        bool busy_poll_sockets = io_busy_poll_sockets;
+        bool edge_triggered = io_edge_triggered;
+        bool batch_releases = io_batch_releases;
         opt_sync.unlock ();
         slot_count = mazmq + ios + 2;
         slots = (mailbox_t**) malloc (sizeof (mailbox_t*) * slot_count);
@@ -192,6 +301,12 @@ zmq::socket_base_t *zmq::ctx_t::create_socket (int type_)
             alloc_assert (io_thread);
             io_threads.push_back (io_thread);
             slots [i] = io_thread->get_mailbox ();
+            if (busy_poll && (!busy_poll_threads ||
+                  (i - 2 < 31 && busy_poll_threads & (1 << (i - 2)))))
+                io_thread->get_poller ()->set_busy_poll (busy_poll,
+                    busy_poll_sockets);
+            io_thread->get_poller ()->set_edge_triggered (edge_triggered);
+            io_thread->get_poller ()->set_batch_releases (batch_releases);
             io_thread->start ();
         }
 
@@ -234,6 +349,11 @@ zmq::socket_base_t *zmq::ctx_t::create_socket (int type_)
     sockets.push_back (s);
     slots [slot] = s->get_mailbox ();
 
+    opt_sync.lock ();
+    int spin = mailbox_spin;
+    opt_sync.unlock ();
+    s->get_mailbox ()->set_spin (spin);
+
     slot_sync.unlock ();
     return s;
 }
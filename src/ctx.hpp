@@ -161,6 +161,29 @@ namespace zmq
         //  Number of I/O threads to launch.
         int io_thread_count;
 
+        //  If true, message content blocks are allocated from the
+        //  thread-caching message pool.
+        bool msg_pool;
+
+        //  Time in nanoseconds the mailboxes of newly created sockets spin
+        //  for commands before going to sleep.
+        int mailbox_spin;
+
+        //  Busy polling window of the I/O threads in microseconds, bitmask
+        //  of the I/O threads to apply it to (0 meaning all of them) and
+        //  whether to set SO_BUSY_POLL on their sockets.
+        int io_busy_poll;
+        int io_busy_poll_threads;
+        bool io_busy_poll_sockets;
+
+        //  If true, I/O threads use edge-triggered notifications where
+        //  possible.
+        bool io_edge_triggered;
+
+        //  If true, I/O threads batch the reference count decrements of
+        //  the messages they close.
+        bool io_batch_releases;
+
         //  Synchronisation of access to context options.
         mutex_t opt_sync;
 
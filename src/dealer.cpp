@@ -104,6 +104,23 @@ bool zmq::dealer_t::xhas_out ()
     return lb.has_out ();
 }
 
+void zmq::dealer_t::xbegin_batch ()
+{
+    lb.begin_batch ();
+}
+
+void zmq::dealer_t::xend_batch ()
+{
+    lb.end_batch ();
+}
+
+void zmq::dealer_t::xget_drops (uint64_t *hwm_drops_, uint64_t *unroutable_drops_)
+{
+    //  Load balancer blocks rather than drops when the pipes are full.
+    *hwm_drops_ = 0;
+    *unroutable_drops_ = lb.get_drops ();
+}
+
 void zmq::dealer_t::xread_activated (pipe_t *pipe_)
 {
     fq.activated (pipe_);
@@ -48,12 +48,15 @@ namespace zmq
         //  Overloads of functions from socket_base_t.
         void xattach_pipe (zmq::pipe_t *pipe_, bool icanhasall_);
         int xsend (zmq::msg_t *msg_, int flags_);
+        void xbegin_batch ();
+        void xend_batch ();
         int xrecv (zmq::msg_t *msg_, int flags_);
         bool xhas_in ();
         bool xhas_out ();
         void xread_activated (zmq::pipe_t *pipe_);
         void xwrite_activated (zmq::pipe_t *pipe_);
         void xterminated (zmq::pipe_t *pipe_);
+        void xget_drops (uint64_t *hwm_drops_, uint64_t *unroutable_drops_);
 
     private:
 
@@ -149,6 +149,9 @@ void zmq::devpoll_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Apply the message releases deferred while handling the events.
+        flush_releases ();
+
         //  Wait for events.
         //  On Solaris, we can retrieve no more then (OPEN_MAX - 1) events.
         poll_req.dp_fds = &ev_buf [0];
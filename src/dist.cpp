@@ -19,6 +19,8 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <new>
+
 #include "dist.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
@@ -29,17 +31,35 @@ zmq::dist_t::dist_t () :
     matching (0),
     active (0),
     eligible (0),
-    more (false)
+    more (false),
+    batching (false),
+    conflate (false),
+    conflate_prefix (0),
+    drops (0)
 {
 }
 
 zmq::dist_t::~dist_t ()
 {
     zmq_assert (pipes.empty ());
+
+    for (size_t i = 0; i != conflated.size (); i++)
+        delete conflated [i];
 }
 
 void zmq::dist_t::attach (pipe_t *pipe_)
 {
+    //  Assign the pipe a slot, reusing the slots of terminated pipes.
+    if (free_slots.empty ()) {
+        pipe_->set_slot ((int) slots.size ());
+        slots.push_back (pipe_);
+    }
+    else {
+        pipe_->set_slot (free_slots.back ());
+        free_slots.pop_back ();
+        slots [pipe_->get_slot ()] = pipe_;
+    }
+
     //  If we are in the middle of sending a message, we'll add new pipe
     //  into the list of eligible pipes. Otherwise we add it to the list
     //  of active pipes.
@@ -56,26 +76,6 @@ void zmq::dist_t::attach (pipe_t *pipe_)
     }
 }
 
-void zmq::dist_t::match (pipe_t *pipe_)
-{
-    //  If pipe is already matching do nothing.
-    if (pipes.index (pipe_) < matching)
-        return;
-
-    //  If the pipe isn't eligible, ignore it.
-    if (pipes.index (pipe_) >= eligible)
-        return;
-
-    //  Mark the pipe as matching.
-    pipes.swap (pipes.index (pipe_), matching);
-    matching++;    
-}
-
-void zmq::dist_t::unmatch ()
-{
-    matching = 0;
-}
-
 void zmq::dist_t::terminated (pipe_t *pipe_)
 {
     //  Remove the pipe from the list; adjust number of matching, active and/or
@@ -94,6 +94,16 @@ void zmq::dist_t::terminated (pipe_t *pipe_)
     }
 
     pipes.erase (pipe_);
+
+    //  Drop the messages held back for the pipe.
+    if ((size_t) pipe_->get_slot () < conflated.size ()) {
+        delete conflated [pipe_->get_slot ()];
+        conflated [pipe_->get_slot ()] = NULL;
+    }
+
+    slots [pipe_->get_slot ()] = NULL;
+    free_slots.push_back (pipe_->get_slot ());
+    pipe_->set_slot (-1);
 }
 
 void zmq::dist_t::activated (pipe_t *pipe_)
@@ -107,32 +117,130 @@ void zmq::dist_t::activated (pipe_t *pipe_)
     if (!more) {
         pipes.swap (eligible - 1, active);
         active++;
+        write_conflated (pipe_);
     }
 }
 
 int zmq::dist_t::send_to_all (msg_t *msg_, int flags_)
 {
+    //  Is this end of a multipart message?
+    bool msg_more = msg_->flags () & msg_t::more ? true : false;
+
+    //  Push the message to all the active pipes.
     matching = active;
-    return send_to_matching (msg_, flags_);
+    distribute (msg_, flags_);
+
+    //  If mutlipart message is fully sent, activate all the eligible pipes.
+    if (!msg_more)
+        active = eligible;
+
+    more = msg_more;
+
+    return 0;
 }
 
-int zmq::dist_t::send_to_matching (msg_t *msg_, int flags_)
+int zmq::dist_t::send_to_slots (msg_t *msg_, int flags_,
+    const bitmap_t &slots_)
 {
+    // flags_ is unused
+    (void)flags_;
+
     //  Is this end of a multipart message?
     bool msg_more = msg_->flags () & msg_t::more ? true : false;
 
-    //  Push the message to matching pipes.
-    distribute (msg_, flags_);
+    //  Push the message to the pipes in the bitmap.
+    distribute_to_slots (msg_, slots_);
 
-    //  If mutlipart message is fully sent, activate all the eligible pipes.
-    if (!msg_more)
+    //  If mutlipart message is fully sent, activate all the eligible pipes
+    //  and pass them whatever was held back for them in the meantime.
+    if (!msg_more) {
+        pipes_t::size_type activated = active;
         active = eligible;
+        for (pipes_t::size_type i = active; i > activated; i--)
+            write_conflated (pipes [i - 1]);
+    }
 
     more = msg_more;
 
     return 0;
 }
 
+void zmq::dist_t::distribute_to_slots (msg_t *msg_, const bitmap_t &slots_)
+{
+    //  Slots beyond the ones ever assigned have no pipes.
+    size_t words = (slots.size () + 63) / 64;
+    if (words > slots_.size ())
+        words = slots_.size ();
+
+    //  Count the candidate pipes. Some of them may turn out to be inactive,
+    //  but that's cheaper to fix afterwards than to check each pipe twice.
+    int candidates = 0;
+    for (size_t i = 0; i != words; i++)
+        candidates += bitmap_count (slots_ [i]);
+
+    //  If there are no matching pipes available, simply drop the message.
+    if (candidates == 0) {
+        int rc = msg_->close ();
+        errno_assert (rc == 0);
+        rc = msg_->init ();
+        errno_assert (rc == 0);
+        return;
+    }
+
+    const bool vsm = msg_->is_vsm ();
+    if (!vsm)
+        msg_->add_refs (candidates - 1);
+
+    //  Push copy of the message to each active pipe in the bitmap. The pipes
+    //  that were attached or re-activated in the middle of a multi-part
+    //  message, or that were terminated, are skipped. With conflation on,
+    //  the message is held back for the pipes that are not active instead,
+    //  unless they already hold as many topics as their high watermark.
+    //  Otherwise it's counted as dropped once per message.
+    int written = 0;
+    for (size_t i = 0; i != words; i++) {
+        for (uint64_t word = slots_ [i]; word; word &= word - 1) {
+            size_t slot = i * 64 + bitmap_lowest (word);
+            pipe_t *pipe = slots [slot];
+            if (!pipe)
+                continue;
+            if (pipes.index (pipe) < active && write (pipe, msg_))
+                written++;
+            else
+            if (conflate) {
+                if (slot >= conflated.size ())
+                    conflated.resize (slot + 1, NULL);
+                if (!conflated [slot]) {
+                    conflated [slot] = new (std::nothrow) conflate_t (
+                        conflate_prefix, (size_t) pipe->get_hwm ());
+                    alloc_assert (conflated [slot]);
+                }
+                if (conflated [slot]->store (msg_, !more))
+                    written++;
+                else
+                if (!more)
+                    drops++;
+            }
+            else
+            if (!more)
+                drops++;
+        }
+    }
+
+    if (vsm) {
+        int rc = msg_->close ();
+        errno_assert (rc == 0);
+    }
+    else
+    if (unlikely (written < candidates))
+        msg_->rm_refs (candidates - written);
+
+    //  Detach the original message from the data buffer. Note that we don't
+    //  close the message. That's because we've already used all the references.
+    int rc = msg_->init ();
+    errno_assert (rc == 0);
+}
+
 void zmq::dist_t::distribute (msg_t *msg_, int flags_)
 {
     // flags_ is unused
@@ -178,6 +286,15 @@ void zmq::dist_t::distribute (msg_t *msg_, int flags_)
     errno_assert (rc == 0);
 }
 
+bool zmq::dist_t::send_to_pipe (pipe_t *pipe_, msg_t *msg_)
+{
+    zmq_assert (!more);
+
+    if (pipes.index (pipe_) >= active)
+        return false;
+    return write (pipe_, msg_);
+}
+
 bool zmq::dist_t::has_out ()
 {
     return true;
@@ -186,16 +303,70 @@ bool zmq::dist_t::has_out ()
 bool zmq::dist_t::write (pipe_t *pipe_, msg_t *msg_)
 {
     if (!pipe_->write (msg_)) {
-        pipes.swap (pipes.index (pipe_), matching - 1);
-        matching--;
-        pipes.swap (pipes.index (pipe_), active - 1);
-        active--;
-        pipes.swap (active, eligible - 1);
-        eligible--;
+        deactivate (pipe_);
         return false;
     }
-    if (!(msg_->flags () & msg_t::more))
+    if (!batching && !(msg_->flags () & msg_t::more))
         pipe_->flush ();
     return true;
 }
 
+void zmq::dist_t::deactivate (pipe_t *pipe_)
+{
+    if (pipes.index (pipe_) < matching) {
+        pipes.swap (pipes.index (pipe_), matching - 1);
+        matching--;
+    }
+    pipes.swap (pipes.index (pipe_), active - 1);
+    active--;
+    pipes.swap (active, eligible - 1);
+    eligible--;
+}
+
+void zmq::dist_t::write_conflated (pipe_t *pipe_)
+{
+    size_t slot = (size_t) pipe_->get_slot ();
+    if (slot >= conflated.size () || !conflated [slot] ||
+          conflated [slot]->empty ())
+        return;
+
+    bool done = conflated [slot]->write (pipe_);
+    if (!batching)
+        pipe_->flush ();
+
+    //  Once the pipe has caught up, release the memory used to hold the
+    //  messages back.
+    if (done) {
+        delete conflated [slot];
+        conflated [slot] = NULL;
+    }
+    else
+        deactivate (pipe_);
+}
+
+void zmq::dist_t::set_conflate (bool conflate_, size_t prefix_)
+{
+    conflate = conflate_;
+    conflate_prefix = prefix_;
+}
+
+uint64_t zmq::dist_t::get_drops ()
+{
+    return drops;
+}
+
+void zmq::dist_t::begin_batch ()
+{
+    batching = true;
+}
+
+void zmq::dist_t::end_batch ()
+{
+    batching = false;
+
+    //  Pipes that hit the high watermark in the middle of the batch may hold
+    //  unflushed messages as well, so flush all of them. Flushing a pipe
+    //  with nothing new written to it is cheap.
+    for (pipes_t::size_type i = 0; i != pipes.size (); i++)
+        pipes [i]->flush ();
+}
@@ -24,6 +24,8 @@
 #include <vector>
 
 #include "array.hpp"
+#include "bitmap.hpp"
+#include "conflate.hpp"
 #include "pipe.hpp"
 
 namespace zmq
@@ -47,33 +49,63 @@ namespace zmq
         //  Activates pipe that have previously reached high watermark.
         void activated (zmq::pipe_t *pipe_);
 
-        //  Mark the pipe as matching. Subsequent call to send_to_matching
-        //  will send message also to this pipe.
-        void match (zmq::pipe_t *pipe_);
-
-        //  Mark all pipes as non-matching.
-        void unmatch ();
-
         //  Removes the pipe from the distributor object.
         void terminated (zmq::pipe_t *pipe_);
 
-        //  Send the message to the matching outbound pipes.
-        int send_to_matching (zmq::msg_t *msg_, int flags_);
-
         //  Send the message to all the outbound pipes.
         int send_to_all (zmq::msg_t *msg_, int flags_);
 
+        //  Send the message to the pipes whose slots are set in the bitmap.
+        //  The bitmap must be the same for all the parts of a multi-part
+        //  message.
+        int send_to_slots (zmq::msg_t *msg_, int flags_,
+            const bitmap_t &slots_);
+
+        //  Send the message to a single pipe, regardless of matching. Fails
+        //  if the pipe is not active. Must not be called in the middle of
+        //  a multi-part message sent to the other pipes.
+        bool send_to_pipe (zmq::pipe_t *pipe_, zmq::msg_t *msg_);
+
         bool has_out ();
 
+        //  Between begin_batch and end_batch the messages written to the
+        //  pipes are not flushed. end_batch flushes every pipe once.
+        void begin_batch ();
+        void end_batch ();
+
+        //  If conflate_ is true, messages sent using send_to_slots that
+        //  would be dropped because a pipe has reached its high watermark
+        //  are held back instead, keeping only the latest one per topic.
+        //  The topic is made of the first prefix_ bytes of the first part,
+        //  or the whole first part if prefix_ is 0. A pipe holds at most as
+        //  many topics as its high watermark; messages with new topics are
+        //  dropped beyond that. The held messages are written, in the byte
+        //  order of their topics, once the pipe is activated again.
+        void set_conflate (bool conflate_, size_t prefix_);
+
+        //  Number of messages not delivered to a matching pipe because
+        //  the pipe has reached its high watermark.
+        uint64_t get_drops ();
+
     private:
 
         //  Write the message to the pipe. Make the pipe inactive if writing
         //  fails. In such a case false is returned.
         bool write (zmq::pipe_t *pipe_, zmq::msg_t *msg_);
 
-        //  Put the message to all active pipes.
+        //  Makes an active pipe inactive.
+        void deactivate (zmq::pipe_t *pipe_);
+
+        //  Writes the messages held back for an active pipe. Makes the pipe
+        //  inactive if they don't fit in.
+        void write_conflated (zmq::pipe_t *pipe_);
+
+        //  Put the message to the first 'matching' active pipes.
         void distribute (zmq::msg_t *msg_, int flags_);
 
+        //  Put the message to all active pipes with slots in the bitmap.
+        void distribute_to_slots (zmq::msg_t *msg_, const bitmap_t &slots_);
+
         //  List of outbound pipes.
         typedef array_t <zmq::pipe_t, 2> pipes_t;
         pipes_t pipes;
@@ -93,9 +125,26 @@ namespace zmq
         //  with initial parts missing.
         pipes_t::size_type eligible;
 
+        //  Pipes indexed by their slot numbers. Slots of terminated pipes
+        //  are NULL until they are reused.
+        std::vector <zmq::pipe_t*> slots;
+        std::vector <int> free_slots;
+
         //  True if last we are in the middle of a multipart message.
         bool more;
 
+        //  True if flushing of the pipes is postponed till end_batch.
+        bool batching;
+
+        //  Messages held back for the pipes, indexed by their slot numbers.
+        //  NULL if nothing was ever held back for the slot.
+        bool conflate;
+        size_t conflate_prefix;
+        std::vector <zmq::conflate_t*> conflated;
+
+        //  Number of messages dropped because of the high watermark.
+        uint64_t drops;
+
         dist_t (const dist_t&);
         const dist_t &operator = (const dist_t&);
     };
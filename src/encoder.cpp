@@ -51,7 +51,8 @@ bool zmq::encoder_t::size_ready ()
 {
     //  Write message body into the buffer.
     next_step (in_progress.data (), in_progress.size (),
-        &encoder_t::message_ready, !(in_progress.flags () & msg_t::more));
+        &encoder_t::message_ready, !(in_progress.flags () & msg_t::more),
+        &in_progress);
     return true;
 }
 
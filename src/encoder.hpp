@@ -33,6 +33,12 @@
 #include <stdlib.h>
 #include <algorithm>
 
+#include "platform.hpp"
+#if defined ZMQ_HAVE_UIO
+#include <sys/uio.h>
+#endif
+
+#include "config.hpp"
 #include "err.hpp"
 #include "msg.hpp"
 #include "i_encoder.hpp"
@@ -49,16 +55,31 @@ namespace zmq
     public:
 
         inline encoder_base_t (size_t bufsize_) :
+            write_msg (NULL),
             bufsize (bufsize_)
         {
             buf = (unsigned char*) malloc (bufsize_);
             alloc_assert (buf);
+#if defined ZMQ_HAVE_UIO
+            iov_pos = 0;
+            iov_count = 0;
+            for (int i = 0; i != out_batch_iov; i++) {
+                int rc = held [i].init ();
+                errno_assert (rc == 0);
+            }
+#endif
         }
 
         //  The destructor doesn't have to be virtual. It is made virtual
         //  just to keep ICC and code checking tools from complaining.
         inline virtual ~encoder_base_t ()
         {
+#if defined ZMQ_HAVE_UIO
+            for (int i = 0; i != out_batch_iov; i++) {
+                int rc = held [i].close ();
+                errno_assert (rc == 0);
+            }
+#endif
             free (buf);
         }
 
@@ -124,11 +145,59 @@ namespace zmq
             *size_ = pos;
         }
 
+#if defined ZMQ_HAVE_UIO
+
+        //  The function returns a batch of binary data as a list of slices
+        //  suitable for writev. Message headers and small message bodies
+        //  are copied into the encoder's buffer, large message bodies are
+        //  referenced in place and the messages are kept alive until
+        //  consume reports them as written. Slices that were not consumed
+        //  yet are returned again instead of encoding new data.
+        inline void get_iov (iovec **iov_, int *iovcnt_)
+        {
+            if (iov_pos == iov_count)
+                fill_iov ();
+            *iov_ = iov + iov_pos;
+            *iovcnt_ = iov_count - iov_pos;
+        }
+
+        //  Marks size_ bytes of the slices returned by get_iov as written.
+        inline void consume (size_t size_)
+        {
+            while (size_) {
+                zmq_assert (iov_pos < iov_count);
+                iovec &slice = iov [iov_pos];
+                if (size_ < slice.iov_len) {
+                    slice.iov_base = (unsigned char*) slice.iov_base + size_;
+                    slice.iov_len -= size_;
+                    return;
+                }
+                size_ -= slice.iov_len;
+
+                //  The slice is fully written. If it referred to a message
+                //  body, the message can be released now.
+                int rc = held [iov_pos].close ();
+                errno_assert (rc == 0);
+                rc = held [iov_pos].init ();
+                errno_assert (rc == 0);
+                iov_pos++;
+            }
+        }
+
+        inline bool has_data ()
+        {
+            return to_write > 0 || iov_pos < iov_count;
+        }
+
+#else
+
         inline bool has_data ()
         {
             return to_write > 0;
         }
 
+#endif
+
     protected:
 
         //  Prototype of state machine action.
@@ -136,18 +205,93 @@ namespace zmq
 
         //  This function should be called from derived class to write the data
         //  to the buffer and schedule next state machine action. Set beginning
-        //  to true when you are writing first byte of a message.
+        //  to true when you are writing first byte of a message. If the data
+        //  are the body of a message, pass the message as msg_ so that
+        //  get_iov can take it over instead of copying the body. The derived
+        //  class must be prepared to find the message empty afterwards.
         inline void next_step (void *write_pos_, size_t to_write_,
-            step_t next_, bool beginning_)
+            step_t next_, bool beginning_, msg_t *msg_ = NULL)
         {
             write_pos = (unsigned char*) write_pos_;
             to_write = to_write_;
             next = next_;
             beginning = beginning_;
+            write_msg = msg_;
         }
 
     private:
 
+#if defined ZMQ_HAVE_UIO
+
+        //  Encodes new data into the list of slices.
+        inline void fill_iov ()
+        {
+            iov_pos = 0;
+            iov_count = 0;
+            size_t pos = 0;
+
+            while (iov_count < out_batch_iov) {
+
+                //  If there are no more data to return, run the state machine.
+                if (!to_write) {
+                    if (!(static_cast <T*> (this)->*next) ())
+                        break;
+                    continue;
+                }
+
+                //  Large message bodies are passed to the kernel directly.
+                //  The message is moved out of the encoder's state machine
+                //  so that it stays alive until the slice is written.
+                if (write_msg && to_write >= out_zero_copy_threshold) {
+                    zmq_assert (!write_msg->is_vsm ());
+                    int rc = held [iov_count].move (*write_msg);
+                    errno_assert (rc == 0);
+                    iov [iov_count].iov_base = write_pos;
+                    iov [iov_count].iov_len = to_write;
+                    iov_count++;
+                    write_msg = NULL;
+                    write_pos = NULL;
+                    to_write = 0;
+                    continue;
+                }
+
+                //  Copy data to the buffer. If the buffer is full, return.
+                size_t to_copy = std::min (to_write, bufsize - pos);
+                if (!to_copy)
+                    break;
+                memcpy (buf + pos, write_pos, to_copy);
+
+                //  Extend the last slice if it ends where the data were
+                //  copied to, otherwise start a new one.
+                if (iov_count && (unsigned char*) iov [iov_count - 1].iov_base +
+                      iov [iov_count - 1].iov_len == buf + pos)
+                    iov [iov_count - 1].iov_len += to_copy;
+                else {
+                    iov [iov_count].iov_base = buf + pos;
+                    iov [iov_count].iov_len = to_copy;
+                    iov_count++;
+                }
+                pos += to_copy;
+                write_pos += to_copy;
+                to_write -= to_copy;
+            }
+        }
+
+        //  Slices of encoded data. Slices between iov_pos and iov_count
+        //  haven't been written yet.
+        iovec iov [out_batch_iov];
+        int iov_pos;
+        int iov_count;
+
+        //  Messages whose bodies are referenced by the slices, stored
+        //  at the same index as the slice. Empty for buffer slices.
+        msg_t held [out_batch_iov];
+
+#endif
+
+        //  Message the data being written belong to, if any.
+        msg_t *write_msg;
+
         //  Where to get the data to write from.
         unsigned char *write_pos;
 
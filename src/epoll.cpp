@@ -32,6 +32,7 @@
 #include "epoll.hpp"
 #include "err.hpp"
 #include "config.hpp"
+#include "clock.hpp"
 #include "i_poll_events.hpp"
 
 zmq::epoll_t::epoll_t () :
@@ -64,6 +65,8 @@ zmq::epoll_t::handle_t zmq::epoll_t::add_fd (fd_t fd_, i_poll_events *events_)
     pe->ev.events = 0;
     pe->ev.data.ptr = pe;
     pe->events = events_;
+    pe->edge_triggered = false;
+    pe->pending = false;
 
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd_, &pe->ev);
     errno_assert (rc != -1);
@@ -89,6 +92,12 @@ void zmq::epoll_t::rm_fd (handle_t handle_)
 void zmq::epoll_t::set_pollin (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
+    if (pe->edge_triggered) {
+        pe->interest |= EPOLLIN;
+        if (pe->in_ready)
+            schedule (pe);
+        return;
+    }
     pe->ev.events |= EPOLLIN;
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
@@ -97,6 +106,10 @@ void zmq::epoll_t::set_pollin (handle_t handle_)
 void zmq::epoll_t::reset_pollin (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
+    if (pe->edge_triggered) {
+        pe->interest &= ~((uint32_t) EPOLLIN);
+        return;
+    }
     pe->ev.events &= ~((short) EPOLLIN);
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
@@ -105,6 +118,12 @@ void zmq::epoll_t::reset_pollin (handle_t handle_)
 void zmq::epoll_t::set_pollout (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
+    if (pe->edge_triggered) {
+        pe->interest |= EPOLLOUT;
+        if (pe->out_ready)
+            schedule (pe);
+        return;
+    }
     pe->ev.events |= EPOLLOUT;
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
@@ -113,11 +132,43 @@ void zmq::epoll_t::set_pollout (handle_t handle_)
 void zmq::epoll_t::reset_pollout (handle_t handle_)
 {
     poll_entry_t *pe = (poll_entry_t*) handle_;
+    if (pe->edge_triggered) {
+        pe->interest &= ~((uint32_t) EPOLLOUT);
+        return;
+    }
     pe->ev.events &= ~((short) EPOLLOUT);
     int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
     errno_assert (rc != -1);
 }
 
+void zmq::epoll_t::enable_edge_triggering (handle_t handle_)
+{
+    if (!edge_triggered)
+        return;
+
+    poll_entry_t *pe = (poll_entry_t*) handle_;
+    zmq_assert (!pe->edge_triggered);
+    pe->edge_triggered = true;
+    pe->interest = pe->ev.events;
+    pe->in_ready = false;
+    pe->out_ready = false;
+
+    //  If the fd is ready already, epoll reports it straight away.
+    pe->ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe->fd, &pe->ev);
+    errno_assert (rc != -1);
+}
+
+void zmq::epoll_t::in_would_block (handle_t handle_)
+{
+    ((poll_entry_t*) handle_)->in_ready = false;
+}
+
+void zmq::epoll_t::out_would_block (handle_t handle_)
+{
+    ((poll_entry_t*) handle_)->out_ready = false;
+}
+
 void zmq::epoll_t::start ()
 {
     worker.start (worker_routine, this);
@@ -132,24 +183,57 @@ void zmq::epoll_t::loop ()
 {
     epoll_event ev_buf [max_io_events];
 
+    //  End of the current busy polling window.
+    uint64_t busy_end = 0;
+
     while (!stopping) {
 
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Apply the message releases deferred while handling the events.
+        flush_releases ();
+
+        //  Within the busy polling window don't block at all.
+        bool busy = false;
+        if (busy_poll) {
+            busy = clock_t::now_us () < busy_end;
+            if (busy)
+                busy_iterations.set (busy_iterations.get () + 1);
+            else
+                idle_iterations.set (idle_iterations.get () + 1);
+        }
+
         //  Wait for events.
+        //  If there are ready edge-triggered entries, don't block either.
         int n = epoll_wait (epoll_fd, &ev_buf [0], max_io_events,
-            timeout ? timeout : -1);
+            busy || !ready.empty () ? 0 : (timeout ? timeout : -1));
         if (n == -1) {
             errno_assert (errno == EINTR);
             continue;
         }
 
+        //  Any activity (re)opens the busy polling window.
+        if (busy_poll && n > 0)
+            busy_end = clock_t::now_us () + busy_poll;
+
         for (int i = 0; i < n; i ++) {
             poll_entry_t *pe = ((poll_entry_t*) ev_buf [i].data.ptr);
 
             if (pe->fd == retired_fd)
                 continue;
+
+            //  Edge-triggered entries only record the readiness here. Their
+            //  handlers are invoked once all the events are processed.
+            if (pe->edge_triggered) {
+                if (ev_buf [i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+                    pe->in_ready = true;
+                if (ev_buf [i].events & (EPOLLOUT | EPOLLERR | EPOLLHUP))
+                    pe->out_ready = true;
+                schedule (pe);
+                continue;
+            }
+
             if (ev_buf [i].events & (EPOLLERR | EPOLLHUP))
                 pe->events->in_event ();
             if (pe->fd == retired_fd)
@@ -162,7 +246,17 @@ void zmq::epoll_t::loop ()
                 pe->events->in_event ();
         }
 
-        //  Destroy retired event sources.
+        dispatch_ready ();
+
+        //  Destroy retired event sources. Make sure none of them is left
+        //  in the list of ready entries.
+        if (!retired.empty () && !ready.empty ()) {
+            ready_t::size_type live = 0;
+            for (ready_t::size_type i = 0; i != ready.size (); i++)
+                if (ready [i]->fd != retired_fd)
+                    ready [live++] = ready [i];
+            ready.resize (live);
+        }
         for (retired_t::iterator it = retired.begin (); it != retired.end ();
               ++it)
             delete *it;
@@ -170,6 +264,44 @@ void zmq::epoll_t::loop ()
     }
 }
 
+void zmq::epoll_t::schedule (poll_entry_t *pe_)
+{
+    if (!pe_->pending) {
+        pe_->pending = true;
+        ready.push_back (pe_);
+    }
+}
+
+void zmq::epoll_t::dispatch_ready ()
+{
+    //  Entries that get ready while dispatching are dispatched on the next
+    //  iteration of the loop.
+    dispatching.swap (ready);
+
+    for (ready_t::size_type i = 0; i != dispatching.size (); i++) {
+        poll_entry_t *pe = dispatching [i];
+        pe->pending = false;
+
+        if (pe->fd == retired_fd)
+            continue;
+        if (pe->out_ready && (pe->interest & EPOLLOUT))
+            pe->events->out_event ();
+        if (pe->fd == retired_fd)
+            continue;
+        if (pe->in_ready && (pe->interest & EPOLLIN))
+            pe->events->in_event ();
+        if (pe->fd == retired_fd)
+            continue;
+
+        //  Until the owner reports that I/O would block, there may be more
+        //  to do. The kernel won't tell us again, so keep dispatching.
+        if ((pe->in_ready && (pe->interest & EPOLLIN)) ||
+              (pe->out_ready && (pe->interest & EPOLLOUT)))
+            schedule (pe);
+    }
+    dispatching.clear ();
+}
+
 void zmq::epoll_t::worker_routine (void *arg_)
 {
     ((epoll_t*) arg_)->loop ();
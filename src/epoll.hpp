@@ -60,6 +60,14 @@ namespace zmq
         void start ();
         void stop ();
 
+        //  Edge-triggered mode. Once enabled for an fd, the fd is registered
+        //  for both input and output once and the set/reset functions above
+        //  don't issue any system calls. The owner of the fd has to report
+        //  when reading or writing would block.
+        void enable_edge_triggering (handle_t handle_);
+        void in_would_block (handle_t handle_);
+        void out_would_block (handle_t handle_);
+
     private:
 
         //  Main worker thread routine.
@@ -76,12 +84,35 @@ namespace zmq
             fd_t fd;
             epoll_event ev;
             zmq::i_poll_events *events;
+
+            //  True if the fd is registered in edge-triggered mode. In that
+            //  case 'interest' holds the events the owner is interested in,
+            //  'in_ready' and 'out_ready' say whether the fd is known to be
+            //  readable or writable, and 'pending' is true if the entry is
+            //  in the list of ready entries.
+            bool edge_triggered;
+            uint32_t interest;
+            bool in_ready;
+            bool out_ready;
+            bool pending;
         };
 
+        //  Puts the edge-triggered entry into the list of ready entries.
+        void schedule (poll_entry_t *pe_);
+
+        //  Invokes the event handlers of the ready edge-triggered entries.
+        void dispatch_ready ();
+
         //  List of retired event sources.
         typedef std::vector <poll_entry_t*> retired_t;
         retired_t retired;
 
+        //  Edge-triggered entries that are ready for the events their owners
+        //  are interested in, and the list being dispatched at the moment.
+        typedef std::vector <poll_entry_t*> ready_t;
+        ready_t ready;
+        ready_t dispatching;
+
         //  If true, thread is in the process of shutting down.
         bool stopping;
 
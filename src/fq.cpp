@@ -91,8 +91,8 @@ int zmq::fq_t::recvpipe (msg_t *msg_, pipe_t **pipe_)
             if (pipe_)
                 *pipe_ = pipes [current];
             more = msg_->flags () & msg_t::more? true: false;
-            if (!more)
-                current = (current + 1) % active;
+            if (!more && ++current == active)
+                current = 0;
             return 0;
         }
 
@@ -21,8 +21,13 @@
 #ifndef __ZMQ_I_ENCODER_HPP_INCLUDED__
 #define __ZMQ_I_ENCODER_HPP_INCLUDED__
 
+#include "platform.hpp"
 #include "stdint.hpp"
 
+#if defined ZMQ_HAVE_UIO
+struct iovec;
+#endif
+
 namespace zmq
 {
 
@@ -47,6 +52,16 @@ namespace zmq
         virtual void get_data (unsigned char **data_, size_t *size_,
             int *offset_ = NULL) = 0;
 
+#if defined ZMQ_HAVE_UIO
+        //  The function returns a batch of binary data as a list of slices
+        //  that can be passed to writev. The slices remain valid until
+        //  they are reported as written by consume.
+        virtual void get_iov (iovec **iov_, int *iovcnt_) = 0;
+
+        //  Reports size_ bytes of the data returned by get_iov as written.
+        virtual void consume (size_t size_) = 0;
+#endif
+
         virtual bool has_data () = 0;
     };
 
@@ -0,0 +1,179 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "identity_table.hpp"
+#include "random.hpp"
+#include "pipe.hpp"
+#include "err.hpp"
+
+zmq::identity_table_t::identity_table_t () :
+    count (0)
+{
+    entry_t empty = {NULL, 0, false};
+    entries.resize (16, empty);
+
+    //  The key must not be guessable by the peers, so it doesn't come from
+    //  the seeded rand().
+    generate_random_bytes (key, sizeof key);
+}
+
+zmq::identity_table_t::~identity_table_t ()
+{
+}
+
+#define ZMQ_SIP_ROTL(x, b) (((x) << (b)) | ((x) >> (64 - (b))))
+
+#define ZMQ_SIP_ROUND \
+    do { \
+        v0 += v1; v1 = ZMQ_SIP_ROTL (v1, 13); v1 ^= v0; \
+        v0 = ZMQ_SIP_ROTL (v0, 32); \
+        v2 += v3; v3 = ZMQ_SIP_ROTL (v3, 16); v3 ^= v2; \
+        v0 += v3; v3 = ZMQ_SIP_ROTL (v3, 21); v3 ^= v0; \
+        v2 += v1; v1 = ZMQ_SIP_ROTL (v1, 17); v1 ^= v2; \
+        v2 = ZMQ_SIP_ROTL (v2, 32); \
+    } while (0)
+
+uint32_t zmq::identity_table_t::hash (const unsigned char *identity_,
+    size_t size_)
+{
+    //  SipHash-2-4. The 64-bit result is folded to 32 bits; all its bits are
+    //  well mixed, so the table can use the low ones as they are.
+    uint64_t v0 = key [0] ^ ((uint64_t) 0x736f6d65 << 32 | 0x70736575);
+    uint64_t v1 = key [1] ^ ((uint64_t) 0x646f7261 << 32 | 0x6e646f6d);
+    uint64_t v2 = key [0] ^ ((uint64_t) 0x6c796765 << 32 | 0x6e657261);
+    uint64_t v3 = key [1] ^ ((uint64_t) 0x74656462 << 32 | 0x79746573);
+
+    const unsigned char *end = identity_ + (size_ & ~(size_t) 7);
+    for (const unsigned char *p = identity_; p != end; p += 8) {
+        uint64_t m = 0;
+        for (int i = 7; i >= 0; i--)
+            m = m << 8 | p [i];
+        v3 ^= m;
+        ZMQ_SIP_ROUND;
+        ZMQ_SIP_ROUND;
+        v0 ^= m;
+    }
+
+    //  The last block holds the remaining bytes and the length.
+    uint64_t b = (uint64_t) size_ << 56;
+    for (int i = (int) (size_ & 7) - 1; i >= 0; i--)
+        b |= (uint64_t) end [i] << (8 * i);
+    v3 ^= b;
+    ZMQ_SIP_ROUND;
+    ZMQ_SIP_ROUND;
+    v0 ^= b;
+
+    v2 ^= 0xff;
+    ZMQ_SIP_ROUND;
+    ZMQ_SIP_ROUND;
+    ZMQ_SIP_ROUND;
+    ZMQ_SIP_ROUND;
+    uint64_t h = v0 ^ v1 ^ v2 ^ v3;
+    return (uint32_t) (h ^ (h >> 32));
+}
+
+zmq::identity_table_t::entry_t *zmq::identity_table_t::find (
+    const unsigned char *identity_, size_t size_, uint32_t hash_)
+{
+    const size_t mask = entries.size () - 1;
+    for (size_t pos = hash_ & mask; entries [pos].pipe; pos = (pos + 1) & mask) {
+        entry_t &entry = entries [pos];
+        if (entry.hash != hash_)
+            continue;
+        const blob_t &identity = entry.pipe->get_identity ();
+        if (identity.size () == size_ &&
+              memcmp (identity.data (), identity_, size_) == 0)
+            return &entry;
+    }
+    return NULL;
+}
+
+zmq::identity_table_t::entry_t *zmq::identity_table_t::find (pipe_t *pipe_)
+{
+    const blob_t &identity = pipe_->get_identity ();
+    const size_t mask = entries.size () - 1;
+    for (size_t pos = hash (identity.data (), identity.size ()) & mask;
+          entries [pos].pipe; pos = (pos + 1) & mask)
+        if (entries [pos].pipe == pipe_)
+            return &entries [pos];
+    return NULL;
+}
+
+void zmq::identity_table_t::insert (pipe_t *pipe_)
+{
+    //  Keep the table at most half full.
+    if ((count + 1) * 2 > entries.size ())
+        resize (entries.size () * 2);
+
+    const size_t mask = entries.size () - 1;
+    const blob_t &identity = pipe_->get_identity ();
+    const uint32_t h = hash (identity.data (), identity.size ());
+    size_t pos = h & mask;
+    while (entries [pos].pipe)
+        pos = (pos + 1) & mask;
+    entries [pos].pipe = pipe_;
+    entries [pos].hash = h;
+    entries [pos].active = true;
+    count++;
+}
+
+void zmq::identity_table_t::erase (pipe_t *pipe_)
+{
+    entry_t *entry = find (pipe_);
+    zmq_assert (entry);
+
+    //  Move the following entries of the cluster back, unless that would
+    //  put them before the position they hash to.
+    const size_t mask = entries.size () - 1;
+    size_t hole = entry - &entries [0];
+    size_t pos = (hole + 1) & mask;
+    while (entries [pos].pipe) {
+        const size_t home = entries [pos].hash & mask;
+        if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+            entries [hole] = entries [pos];
+            hole = pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    entries [hole].pipe = NULL;
+    count--;
+}
+
+bool zmq::identity_table_t::empty ()
+{
+    return count == 0;
+}
+
+void zmq::identity_table_t::resize (size_t size_)
+{
+    entry_t empty = {NULL, 0, false};
+    entries_t old (size_, empty);
+    old.swap (entries);
+
+    const size_t mask = size_ - 1;
+    for (entries_t::iterator it = old.begin (); it != old.end (); ++it)
+        if (it->pipe) {
+            size_t pos = it->hash & mask;
+            while (entries [pos].pipe)
+                pos = (pos + 1) & mask;
+            entries [pos] = *it;
+        }
+}
@@ -0,0 +1,99 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_IDENTITY_TABLE_HPP_INCLUDED__
+#define __ZMQ_IDENTITY_TABLE_HPP_INCLUDED__
+
+#include <vector>
+#include <stddef.h>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    class pipe_t;
+
+    //  Table of pipes keyed by the identities of their peers, implemented
+    //  as an open addressing hash table with linear probing. The identities
+    //  are chosen by the peers, so they are hashed with SipHash keyed by a
+    //  random key of the table; otherwise a peer could pick identities that
+    //  collide and make each lookup scan the whole table. The key is read
+    //  from /dev/urandom; on systems without it, it comes from rand() and
+    //  can be guessed by a peer that knows the seed. The hashes are
+    //  stored in the entries, and looking a pipe up allocates no memory.
+
+    class identity_table_t
+    {
+    public:
+
+        struct entry_t
+        {
+            zmq::pipe_t *pipe;
+            uint32_t hash;
+
+            //  Flag to be used by the owner of the table.
+            bool active;
+        };
+
+        identity_table_t ();
+        ~identity_table_t ();
+
+        //  Hashes the identity with the key of this table.
+        uint32_t hash (const unsigned char *identity_, size_t size_);
+
+        //  Returns the entry of the pipe with the identity, NULL if there's
+        //  no such pipe. hash_ is the hash of the identity computed by this
+        //  table. Entries are valid till the table is modified.
+        entry_t *find (const unsigned char *identity_, size_t size_,
+            uint32_t hash_);
+
+        //  Returns the entry of the pipe, NULL if the pipe is not in the table.
+        entry_t *find (zmq::pipe_t *pipe_);
+
+        //  Adds the pipe under its identity. There must be no other pipe
+        //  with the same identity in the table. The 'active' flag is set.
+        void insert (zmq::pipe_t *pipe_);
+
+        //  Removes the pipe from the table.
+        void erase (zmq::pipe_t *pipe_);
+
+        bool empty ();
+
+    private:
+
+        void resize (size_t size_);
+
+        //  The size of the table is a power of 2. Empty entries have no pipe.
+        typedef std::vector <entry_t> entries_t;
+        entries_t entries;
+
+        //  Number of pipes in the table.
+        size_t count;
+
+        //  SipHash key.
+        uint64_t key [2];
+
+        identity_table_t (const identity_table_t&);
+        const identity_table_t &operator = (const identity_table_t&);
+    };
+
+}
+
+#endif
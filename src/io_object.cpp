@@ -92,6 +92,33 @@ void zmq::io_object_t::cancel_timer (int id_)
     poller->cancel_timer (this, id_);
 }
 
+void zmq::io_object_t::enable_edge_triggering (handle_t handle_)
+{
+#if defined ZMQ_USE_EPOLL
+    poller->enable_edge_triggering (handle_);
+#else
+    (void) handle_;
+#endif
+}
+
+void zmq::io_object_t::in_would_block (handle_t handle_)
+{
+#if defined ZMQ_USE_EPOLL
+    poller->in_would_block (handle_);
+#else
+    (void) handle_;
+#endif
+}
+
+void zmq::io_object_t::out_would_block (handle_t handle_)
+{
+#if defined ZMQ_USE_EPOLL
+    poller->out_would_block (handle_);
+#else
+    (void) handle_;
+#endif
+}
+
 void zmq::io_object_t::in_event ()
 {
     zmq_assert (false);
@@ -63,6 +63,14 @@ namespace zmq
         void add_timer (int timout_, int id_);
         void cancel_timer (int id_);
 
+        //  An object that calls in_would_block and out_would_block whenever
+        //  reading from or writing to the fd would block may ask the poller
+        //  to switch the fd to edge-triggered notifications. Pollers that
+        //  don't support them ignore these calls.
+        void enable_edge_triggering (handle_t handle_);
+        void in_would_block (handle_t handle_);
+        void out_would_block (handle_t handle_);
+
         //  i_poll_events interface implementation.
         void in_event ();
         void out_event ();
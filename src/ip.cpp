@@ -107,3 +107,16 @@ void zmq::enable_ipv4_mapping (fd_t s_)
 #endif
 #endif
 }
+
+void zmq::set_busy_poll (fd_t s_, int busy_poll_)
+{
+#ifdef SO_BUSY_POLL
+    //  Raising the value above the system default requires CAP_NET_ADMIN.
+    int rc = setsockopt (s_, SOL_SOCKET, SO_BUSY_POLL, &busy_poll_,
+        sizeof (busy_poll_));
+    (void) rc;
+#else
+    (void) s_;
+    (void) busy_poll_;
+#endif
+}
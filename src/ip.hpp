@@ -36,6 +36,11 @@ namespace zmq
     //  Enable IPv4-mapping of addresses in case it is disabled by default.
     void enable_ipv4_mapping (fd_t s_);
 
+    //  Asks the kernel to busy poll the device queue for busy_poll_
+    //  microseconds when there's no data on the socket (SO_BUSY_POLL).
+    //  This is an optimisation only, so failures are ignored.
+    void set_busy_poll (fd_t s_, int busy_poll_);
+
 }
 
 #endif 
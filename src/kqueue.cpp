@@ -158,6 +158,9 @@ void zmq::kqueue_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Apply the message releases deferred while handling the events.
+        flush_releases ();
+
         //  Wait for events.
         struct kevent ev_buf [max_io_events];
         timespec ts = {timeout / 1000, (timeout % 1000) * 1000000};
@@ -29,7 +29,9 @@ zmq::lb_t::lb_t () :
     active (0),
     current (0),
     more (false),
-    dropping (false)
+    dropping (false),
+    batching (false),
+    drops (0)
 {
 }
 
@@ -82,6 +84,8 @@ int zmq::lb_t::send (msg_t *msg_, int flags_)
 
         more = msg_->flags () & msg_t::more ? true : false;
         dropping = more;
+        if (!dropping)
+            drops++;
 
         int rc = msg_->close ();
         errno_assert (rc == 0);
@@ -112,7 +116,8 @@ int zmq::lb_t::send (msg_t *msg_, int flags_)
     //  continue round-robinning (load balance).
     more = msg_->flags () & msg_t::more? true: false;
     if (!more) {
-        pipes [current]->flush ();
+        if (!batching)
+            pipes [current]->flush ();
         if (++current >= active)
             current = 0;
     }
@@ -147,3 +152,23 @@ bool zmq::lb_t::has_out ()
     return false;
 }
 
+uint64_t zmq::lb_t::get_drops ()
+{
+    return drops;
+}
+
+void zmq::lb_t::begin_batch ()
+{
+    batching = true;
+}
+
+void zmq::lb_t::end_batch ()
+{
+    batching = false;
+
+    //  Pipes that were deactivated in the middle of the batch may hold
+    //  unflushed messages as well, so flush all of them. Flushing a pipe
+    //  with nothing new written to it is cheap.
+    for (pipes_t::size_type i = 0; i != pipes.size (); i++)
+        pipes [i]->flush ();
+}
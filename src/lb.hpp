@@ -45,6 +45,15 @@ namespace zmq
         int send (msg_t *msg_, int flags_);
         bool has_out ();
 
+        //  Between begin_batch and end_batch the messages written to the
+        //  pipes are not flushed. end_batch flushes every pipe once.
+        void begin_batch ();
+        void end_batch ();
+
+        //  Number of messages whose remainder was dropped because the pipe
+        //  they were being sent to has disconnected.
+        uint64_t get_drops ();
+
     private:
 
         //  List of outbound pipes.
@@ -64,6 +73,12 @@ namespace zmq
         //  True if we are dropping current message.
         bool dropping;
 
+        //  True if flushing of the pipes is postponed till end_batch.
+        bool batching;
+
+        //  Number of messages dropped because their pipe has disconnected.
+        uint64_t drops;
+
         lb_t (const lb_t&);
         const lb_t &operator = (const lb_t&);
     };
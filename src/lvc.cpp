@@ -0,0 +1,141 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "lvc.hpp"
+#include "err.hpp"
+
+zmq::lvc_t::lvc_t () :
+    current_size (0),
+    size (0),
+    max_size (0),
+    prefix (0)
+{
+}
+
+zmq::lvc_t::~lvc_t ()
+{
+    set_limits (0, 0);
+}
+
+void zmq::lvc_t::set_limits (size_t max_size_, size_t prefix_)
+{
+    //  The topics cached so far don't apply with a different prefix.
+    if (prefix_ != prefix)
+        while (!topics.empty ())
+            evict (topics.begin ());
+    prefix = prefix_;
+
+    max_size = max_size_;
+    while (size > max_size)
+        evict (topics.find (*lru.front ()));
+    if (!max_size) {
+        close (current);
+        current_size = 0;
+    }
+}
+
+bool zmq::lvc_t::enabled ()
+{
+    return max_size != 0;
+}
+
+void zmq::lvc_t::store (msg_t *msg_, bool first_)
+{
+    //  Drop the remainder of a message whose first part wasn't seen.
+    if (first_) {
+        close (current);
+        current_size = 0;
+    }
+    else
+    if (current.empty ())
+        return;
+
+    msg_t copy;
+    int rc = copy.init ();
+    errno_assert (rc == 0);
+    rc = copy.copy (*msg_);
+    errno_assert (rc == 0);
+    current.push_back (copy);
+    current_size += msg_->size ();
+    if (msg_->flags () & msg_t::more)
+        return;
+
+    //  The message is complete. Replace the one cached for the topic.
+    size_t topic_size = current [0].size ();
+    if (prefix && topic_size > prefix)
+        topic_size = prefix;
+    blob_t topic ((unsigned char*) current [0].data (), topic_size);
+    size_t entry_size = current_size;
+    current_size = 0;
+
+    topics_t::iterator it = topics.find (topic);
+    if (it != topics.end ())
+        evict (it);
+
+    //  Messages that don't fit into the cache on their own are not cached.
+    if (entry_size > max_size) {
+        close (current);
+        return;
+    }
+
+    //  Make room by evicting the topics not updated for the longest time.
+    while (size + entry_size > max_size)
+        evict (topics.find (*lru.front ()));
+
+    it = topics.insert (topics_t::value_type (topic, entry_t ())).first;
+    it->second.parts.swap (current);
+    it->second.size = entry_size;
+    it->second.lru = lru.insert (lru.end (), &it->first);
+    size += entry_size;
+}
+
+void zmq::lvc_t::match (const unsigned char *data_, size_t size_,
+    void (*func_) (msg_t *parts_, size_t count_, void *arg_), void *arg_)
+{
+    //  Only the topics starting with the corresponding part of the prefix
+    //  can match. They form a contiguous range of the map.
+    blob_t key (data_, prefix && size_ > prefix ? prefix : size_);
+    for (topics_t::iterator it = topics.lower_bound (key);
+          it != topics.end () &&
+          it->first.compare (0, key.size (), key) == 0; ++it) {
+        msg_t &first = it->second.parts [0];
+        if (first.size () >= size_ &&
+              (!size_ || memcmp (first.data (), data_, size_) == 0))
+            func_ (&it->second.parts [0], it->second.parts.size (), arg_);
+    }
+}
+
+void zmq::lvc_t::evict (topics_t::iterator it_)
+{
+    close (it_->second.parts);
+    size -= it_->second.size;
+    lru.erase (it_->second.lru);
+    topics.erase (it_);
+}
+
+void zmq::lvc_t::close (parts_t &parts_)
+{
+    for (parts_t::size_type i = 0; i != parts_.size (); i++) {
+        int rc = parts_ [i].close ();
+        errno_assert (rc == 0);
+    }
+    parts_.clear ();
+}
@@ -0,0 +1,115 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_LVC_HPP_INCLUDED__
+#define __ZMQ_LVC_HPP_INCLUDED__
+
+#include <list>
+#include <map>
+#include <vector>
+#include <stddef.h>
+
+#include "blob.hpp"
+#include "msg.hpp"
+
+namespace zmq
+{
+
+    //  Last value cache. Keeps a copy of the latest message published on
+    //  each topic so that it can be replayed to new subscribers. The topic
+    //  is made of the leading bytes of the first part of the message. When
+    //  the cache grows beyond its size limit, the topics that were not
+    //  updated for the longest time are evicted.
+
+    class lvc_t
+    {
+    public:
+
+        lvc_t ();
+        ~lvc_t ();
+
+        //  Sets the maximal number of bytes of message data to keep and
+        //  the number of leading bytes of the first part forming the topic,
+        //  0 meaning the whole part. Setting max_size_ to 0 disables the
+        //  cache and drops all the cached messages.
+        void set_limits (size_t max_size_, size_t prefix_);
+
+        //  Returns true if the messages should be passed to the cache.
+        bool enabled ();
+
+        //  Records a copy of a message part being published. first_ tells
+        //  whether it's the first part of the message. Once the last part
+        //  arrives, the message replaces the one cached for its topic.
+        void store (zmq::msg_t *msg_, bool first_);
+
+        //  Invokes the callback for each cached message whose first part
+        //  starts with the prefix, in the order of their topics.
+        void match (const unsigned char *data_, size_t size_,
+            void (*func_) (zmq::msg_t *parts_, size_t count_, void *arg_),
+            void *arg_);
+
+    private:
+
+        typedef std::vector <msg_t> parts_t;
+
+        //  Topics in the order of eviction. The keys are owned by the map.
+        typedef std::list <const blob_t*> lru_t;
+
+        struct entry_t
+        {
+            parts_t parts;
+
+            //  Total size of the parts.
+            size_t size;
+
+            //  Position of the topic in the eviction order.
+            lru_t::iterator lru;
+        };
+
+        typedef std::map <blob_t, entry_t> topics_t;
+
+        //  Drops all the parts and empties the vector.
+        static void close (parts_t &parts_);
+
+        //  Removes the entry from the cache.
+        void evict (topics_t::iterator it_);
+
+        //  Cached messages and the order to evict them in, least recently
+        //  updated first.
+        topics_t topics;
+        lru_t lru;
+
+        //  Parts of the message being published at the moment.
+        parts_t current;
+        size_t current_size;
+
+        //  Number of bytes held by the cached messages and the limit.
+        size_t size;
+        size_t max_size;
+
+        //  Number of leading bytes of the first part forming the topic.
+        size_t prefix;
+
+        lvc_t (const lvc_t&);
+        const lvc_t &operator = (const lvc_t&);
+    };
+
+}
+
+#endif
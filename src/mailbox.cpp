@@ -20,9 +20,12 @@
 */
 
 #include "mailbox.hpp"
+#include "clock.hpp"
 #include "err.hpp"
 
-zmq::mailbox_t::mailbox_t ()
+zmq::mailbox_t::mailbox_t () :
+    spin_ns (0),
+    spinning (false)
 {
     //  Get the pipe into passive state. That way, if the users starts by
     //  polling on the associated file descriptor it will get woken up when
@@ -52,6 +55,10 @@ void zmq::mailbox_t::send (const command_t &cmd_)
     sync.lock ();
     cpipe.write (cmd_, false);
     bool ok = cpipe.flush ();
+
+    //  If the reader is spinning, it will find the command by itself.
+    if (!ok && spinning)
+        ok = true;
     sync.unlock ();
     if (!ok)
         signaler.send ();
@@ -66,8 +73,32 @@ int zmq::mailbox_t::recv (command_t *cmd_, int timeout_)
             return 0;
 
         //  If there are no more commands available, switch into passive state.
+        //  No signal was sent to a spinning reader, so there's none to
+        //  consume in that case.
         active = false;
-        signaler.recv ();
+        if (!spinning)
+            signaler.recv ();
+    }
+
+    //  If we are going to wait, poll the pipe for a while first.
+    if (spin_ns && timeout_ != 0 && spin (cmd_)) {
+        active = true;
+        return 0;
+    }
+
+    //  Before going to sleep, let the writers know they have to signal us
+    //  again. Commands that were written in the meantime were not signaled,
+    //  so check for them while still holding the lock.
+    if (spinning) {
+        sync.lock ();
+        bool ok = cpipe.read (cmd_);
+        if (!ok)
+            spinning = false;
+        sync.unlock ();
+        if (ok) {
+            active = true;
+            return 0;
+        }
     }
 
     //  Wait for signal from the command sender.
@@ -85,3 +116,38 @@ int zmq::mailbox_t::recv (command_t *cmd_, int timeout_)
     return 0;
 }
 
+void zmq::mailbox_t::set_spin (int spin_ns_)
+{
+    zmq_assert (!spinning);
+    spin_ns = spin_ns_;
+}
+
+bool zmq::mailbox_t::spin (command_t *cmd_)
+{
+    if (!spinning) {
+
+        //  Ask the writers to stop signaling. If a command arrived since the
+        //  pipe was found empty, its writer has signaled us already; the
+        //  signal is consumed once the pipe gets empty again.
+        sync.lock ();
+        bool ok = cpipe.read (cmd_);
+        if (!ok)
+            spinning = true;
+        sync.unlock ();
+        if (ok)
+            return true;
+    }
+
+    uint64_t end = clock_t::now_us () * 1000 + spin_ns;
+    while (true) {
+        for (int i = 0; i != mailbox_spin_checks; i++) {
+            if (cpipe.read (cmd_))
+                return true;
+#if (defined __GNUC__ && (defined __i386__ || defined __x86_64__))
+            __asm__ volatile ("pause");
+#endif
+        }
+        if (clock_t::now_us () * 1000 >= end)
+            return false;
+    }
+}
@@ -45,9 +45,18 @@ namespace zmq
         fd_t get_fd ();
         void send (const command_t &cmd_);
         int recv (command_t *cmd_, int timeout_);
-        
+
+        //  Sets the time, in nanoseconds, for which recv keeps polling the
+        //  command pipe before going to sleep on the signaler. Zero means
+        //  the mailbox goes to sleep straight away.
+        void set_spin (int spin_ns_);
+
     private:
 
+        //  Polls the command pipe for spin_ns nanoseconds. Returns true if
+        //  a command was retrieved.
+        bool spin (command_t *cmd_);
+
         //  The pipe to store actual commands.
         typedef ypipe_t <command_t, command_pipe_granularity> cpipe_t;
         cpipe_t cpipe;
@@ -65,6 +74,14 @@ namespace zmq
         //  read commands from it.
         bool active;
 
+        //  Time to spin before going to sleep, in nanoseconds.
+        int spin_ns;
+
+        //  True if the reader polls the pipe by itself and thus the writers
+        //  don't have to signal it. The flag is modified by the reader only,
+        //  always with 'sync' locked.
+        bool spinning;
+
         //  Disable copying of mailbox_t object.
         mailbox_t (const mailbox_t&);
         const mailbox_t &operator = (const mailbox_t&);
@@ -26,9 +26,16 @@
 #include <stdlib.h>
 #include <new>
 
+#include "platform.hpp"
+#if !defined ZMQ_HAVE_WINDOWS
+#include <pthread.h>
+#define ZMQ_MSG_BATCH_RELEASES
+#endif
+
 #include "stdint.hpp"
 #include "likely.hpp"
 #include "err.hpp"
+#include "msg_pool.hpp"
 
 //  Check whether the sizes of public representation of the message (zmq_msg_t)
 //  and private represenation of the message (zmq::msg_t) match.
@@ -59,7 +66,7 @@ int zmq::msg_t::init_size (size_t size_)
         u.lmsg.type = type_lmsg;
         u.lmsg.flags = 0;
         u.lmsg.content =
-            (content_t*) malloc (sizeof (content_t) + size_);
+            (content_t*) msg_pool_alloc (sizeof (content_t) + size_);
         if (!u.lmsg.content) {
             errno = ENOMEM;
             return -1;
@@ -79,7 +86,7 @@ int zmq::msg_t::init_data (void *data_, size_t size_, msg_free_fn *ffn_,
 {
     u.lmsg.type = type_lmsg;
     u.lmsg.flags = 0;
-    u.lmsg.content = (content_t*) malloc (sizeof (content_t));
+    u.lmsg.content = (content_t*) msg_pool_alloc (sizeof (content_t));
     if (!u.lmsg.content) {
         errno = ENOMEM;
         return -1;
@@ -112,19 +119,14 @@ int zmq::msg_t::close ()
     if (u.base.type == type_lmsg) {
 
         //  If the content is not shared, or if it is shared and the reference
-        //  count has dropped to zero, deallocate it.
-        if (!(u.lmsg.flags & msg_t::shared) ||
-              !u.lmsg.content->refcnt.sub (1)) {
-
-            //  We used "placement new" operator to initialize the reference
-            //  counter so we call the destructor explicitly now.
-            u.lmsg.content->refcnt.~atomic_counter_t ();
-
-            if (u.lmsg.content->ffn)
-                u.lmsg.content->ffn (u.lmsg.content->data,
-                    u.lmsg.content->hint);
-            free (u.lmsg.content);
-        }
+        //  count has dropped to zero, deallocate it. Threads batching their
+        //  releases leave the shared content to the next flush.
+        if (!(u.lmsg.flags & msg_t::shared))
+            free_content (u.lmsg.content);
+        else
+        if (!defer_release (u.lmsg.content) &&
+              !u.lmsg.content->refcnt.sub (1))
+            free_content (u.lmsg.content);
     }
 
     //  Make the message invalid.
@@ -283,17 +285,147 @@ bool zmq::msg_t::rm_refs (int refs_)
 
     //  The only message type that needs special care are long messages.
     if (!u.lmsg.content->refcnt.sub (refs_)) {
-        //  We used "placement new" operator to initialize the reference
-        //  counter so we call the destructor explicitly now.
-        u.lmsg.content->refcnt.~atomic_counter_t ();
+        free_content (u.lmsg.content);
+        return false;
+    }
+
+    return true;
+}
+
+void zmq::msg_t::free_content (content_t *content_)
+{
+    //  We used "placement new" operator to initialize the reference
+    //  counter so we call the destructor explicitly now.
+    content_->refcnt.~atomic_counter_t ();
+
+    if (content_->ffn)
+        content_->ffn (content_->data, content_->hint);
+    msg_pool_free (content_);
+}
+
+struct zmq::msg_t::release_batch_t
+{
+    //  Contents with deferred decrements and the number of references
+    //  to drop from each of them.
+    content_t *contents [release_batch_size];
+    int refs [release_batch_size];
 
-        if (u.lmsg.content->ffn)
-            u.lmsg.content->ffn (u.lmsg.content->data, u.lmsg.content->hint);
-        free (u.lmsg.content);
+    //  Number of entries in use and the entry most recently added to.
+    int count;
+    int last;
+
+    //  Entry to evict when the batch is full.
+    int victim;
+};
+
+#if defined ZMQ_MSG_BATCH_RELEASES
+
+static pthread_key_t batch_key;
+static pthread_once_t batch_key_once = PTHREAD_ONCE_INIT;
+
+static void release_batch (void *batch_)
+{
+    //  Owner thread is exiting. Apply whatever is still deferred.
+    int rc = pthread_setspecific (batch_key, batch_);
+    posix_assert (rc);
+    zmq::msg_t::flush_releases ();
+    rc = pthread_setspecific (batch_key, NULL);
+    posix_assert (rc);
+    free (batch_);
+}
+
+static void create_batch_key ()
+{
+    int rc = pthread_key_create (&batch_key, release_batch);
+    posix_assert (rc);
+}
+
+void zmq::msg_t::batch_releases ()
+{
+    int rc = pthread_once (&batch_key_once, create_batch_key);
+    posix_assert (rc);
+    if (pthread_getspecific (batch_key))
+        return;
 
+    release_batch_t *batch =
+        (release_batch_t*) malloc (sizeof (release_batch_t));
+    alloc_assert (batch);
+    batch->count = 0;
+    batch->last = 0;
+    batch->victim = 0;
+    rc = pthread_setspecific (batch_key, batch);
+    posix_assert (rc);
+}
+
+void zmq::msg_t::flush_releases ()
+{
+    int rc = pthread_once (&batch_key_once, create_batch_key);
+    posix_assert (rc);
+    release_batch_t *batch = (release_batch_t*) pthread_getspecific (batch_key);
+    if (!batch)
+        return;
+
+    for (int i = 0; i != batch->count; i++)
+        if (!batch->contents [i]->refcnt.sub (batch->refs [i]))
+            free_content (batch->contents [i]);
+    batch->count = 0;
+    batch->last = 0;
+    batch->victim = 0;
+}
+
+bool zmq::msg_t::defer_release (content_t *content_)
+{
+    int rc = pthread_once (&batch_key_once, create_batch_key);
+    posix_assert (rc);
+    release_batch_t *batch = (release_batch_t*) pthread_getspecific (batch_key);
+    if (!batch)
         return false;
+
+    //  Copies of one message tend to be closed back to back.
+    if (batch->count && batch->contents [batch->last] == content_) {
+        batch->refs [batch->last]++;
+        return true;
+    }
+    for (int i = 0; i != batch->count; i++)
+        if (batch->contents [i] == content_) {
+            batch->refs [i]++;
+            batch->last = i;
+            return true;
+        }
+
+    //  If the batch is full, apply the decrements of one of the entries
+    //  to make room for the new content.
+    int pos = batch->count;
+    if (pos == release_batch_size) {
+        pos = batch->victim;
+        batch->victim = (batch->victim + 1) % release_batch_size;
+        if (!batch->contents [pos]->refcnt.sub (batch->refs [pos]))
+            free_content (batch->contents [pos]);
     }
+    else
+        batch->count++;
 
+    batch->contents [pos] = content_;
+    batch->refs [pos] = 1;
+    batch->last = pos;
     return true;
 }
 
+#else
+
+void zmq::msg_t::batch_releases ()
+{
+    //  Thread-specific data are not supported on this platform.
+}
+
+void zmq::msg_t::flush_releases ()
+{
+}
+
+bool zmq::msg_t::defer_release (content_t *)
+{
+    return false;
+}
+
+#endif
+
@@ -81,11 +81,28 @@ namespace zmq
         //  references drops to 0, the message is closed and false is returned.
         bool rm_refs (int refs_);
 
+        //  Makes the calling thread defer the reference count decrements of
+        //  the shared messages it closes until flush_releases is called.
+        //  Decrements of the same content are then applied as a single
+        //  atomic operation. Meant for the I/O threads, which tend to close
+        //  a message fanned out to many peers many times in a row. Has no
+        //  effect on platforms without thread-specific data.
+        static void batch_releases ();
+
+        //  Applies the decrements deferred by the calling thread so far.
+        static void flush_releases ();
+
     private:
 
         //  Size in bytes of the largest message that is still copied around
-        //  rather than being reference-counted.
+        //  rather than being reference-counted. The whole structure has to
+        //  fit into zmq_msg_t, i.e. 32 bytes or, with ZMQ_CACHELINE_MSG,
+        //  a single 64-byte cache line.
+#if defined ZMQ_CACHELINE_MSG
+        enum {max_vsm_size = 61};
+#else
         enum {max_vsm_size = 29};
+#endif
 
         //  Shared message buffer. Message data are either allocated in one
         //  continuous block along with this structure - thus avoiding one
@@ -103,6 +120,16 @@ namespace zmq
             zmq::atomic_counter_t refcnt;
         };
 
+        //  Decrements deferred by a thread batching its releases.
+        struct release_batch_t;
+
+        //  Defers dropping one reference to content_ if the calling thread
+        //  batches its releases. Returns false if it does not.
+        static bool defer_release (content_t *content_);
+
+        //  Deallocates content_ once it has no references left.
+        static void free_content (content_t *content_);
+
         //  Different message types.
         enum type_t
         {
@@ -0,0 +1,364 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <new>
+
+#include "platform.hpp"
+#if !defined ZMQ_HAVE_WINDOWS
+#include <pthread.h>
+#define ZMQ_MSG_POOL_THREAD_CACHE
+#endif
+
+#include "msg_pool.hpp"
+#include "atomic_counter.hpp"
+#include "atomic_ptr.hpp"
+#include "config.hpp"
+#include "likely.hpp"
+#include "mutex.hpp"
+#include "err.hpp"
+
+namespace zmq
+{
+
+    struct msg_pool_arena_t;
+
+    //  Header preceding every block handed out by the pool.
+    struct msg_pool_block_t
+    {
+        //  Arena that owns the block. NULL if the block was allocated
+        //  directly by malloc and is not subject to caching.
+        msg_pool_arena_t *arena;
+
+        //  Size class while the block is in use, link to the next block
+        //  while it is sitting in one of the free lists.
+        union {
+            size_t size_class;
+            msg_pool_block_t *next;
+        };
+    };
+
+    enum
+    {
+        //  Block sizes (including the header) are powers of two starting
+        //  at 64 bytes and ending at 8 kB.
+        msg_pool_min_block = 64,
+        msg_pool_classes = 8
+    };
+
+    struct msg_pool_arena_t
+    {
+        //  Blocks available to the owner thread.
+        msg_pool_block_t *local [msg_pool_classes];
+        int local_count [msg_pool_classes];
+
+        //  Allocation statistics. Written to by the owner thread only, so
+        //  they are bumped by a plain store rather than a locked add.
+        //  Other threads may read them at any time. The counters wrap
+        //  around at 2^32.
+        atomic_counter_t hits;
+        atomic_counter_t misses;
+
+        //  Avoid false sharing between the thread-private data above and
+        //  the lists of blocks freed by other threads below.
+        unsigned char padding [64];
+
+        //  Blocks released by other threads.
+        atomic_ptr_t <msg_pool_block_t> remote [msg_pool_classes];
+
+        //  All the arenas ever created are kept in a linked list.
+        msg_pool_arena_t *next_arena;
+
+        //  1 if the thread that owned the arena has exited and the arena
+        //  can be adopted by a new thread, 0 otherwise. An orphaned arena
+        //  caches no blocks. Changed under arenas_sync, but read by other
+        //  threads without the lock.
+        atomic_counter_t orphaned;
+    };
+
+}
+
+//  Number of contexts that have the pool enabled.
+static zmq::atomic_counter_t users;
+
+//  List of all the arenas and the lock protecting it.
+static zmq::mutex_t arenas_sync;
+static zmq::msg_pool_arena_t *arenas = NULL;
+
+static inline size_t block_size (size_t size_class_)
+{
+    return (size_t) zmq::msg_pool_min_block << size_class_;
+}
+
+static inline size_t max_cached (size_t size_class_)
+{
+    return zmq::msg_pool_cache_size / block_size (size_class_);
+}
+
+//  Frees all the blocks in the list.
+static void free_blocks (zmq::msg_pool_block_t *block_)
+{
+    while (block_) {
+        zmq::msg_pool_block_t *next = block_->next;
+        free (block_);
+        block_ = next;
+    }
+}
+
+//  Frees the blocks cached in the arena's local free lists. Must be called
+//  by the owner thread.
+static void release_local (zmq::msg_pool_arena_t *arena_)
+{
+    for (int i = 0; i != zmq::msg_pool_classes; i++) {
+        free_blocks (arena_->local [i]);
+        arena_->local [i] = NULL;
+        arena_->local_count [i] = 0;
+    }
+}
+
+//  Frees the blocks handed back to the arena by other threads.
+static void release_remote (zmq::msg_pool_arena_t *arena_)
+{
+    for (int i = 0; i != zmq::msg_pool_classes; i++)
+        free_blocks (arena_->remote [i].xchg (NULL));
+}
+
+#if defined ZMQ_MSG_POOL_THREAD_CACHE
+
+static pthread_key_t arena_key;
+static pthread_once_t arena_key_once = PTHREAD_ONCE_INIT;
+
+static void release_arena (void *arena_)
+{
+    //  Owner thread is exiting. The arena itself can't be deallocated as
+    //  blocks still in use refer to it, but the cached blocks are freed.
+    //  The blocks that are still in use will be freed directly as well.
+    zmq::msg_pool_arena_t *arena = (zmq::msg_pool_arena_t*) arena_;
+    release_local (arena);
+    arenas_sync.lock ();
+    arena->orphaned.add (1);
+    arenas_sync.unlock ();
+
+    //  A thread that didn't see the flag yet may still push a block after
+    //  this point. It checks the flag again once the block is pushed and
+    //  frees the list itself in that case.
+    release_remote (arena);
+}
+
+static void create_arena_key ()
+{
+    int rc = pthread_key_create (&arena_key, release_arena);
+    posix_assert (rc);
+}
+
+static zmq::msg_pool_arena_t *get_arena (bool create_)
+{
+    int rc = pthread_once (&arena_key_once, create_arena_key);
+    posix_assert (rc);
+    zmq::msg_pool_arena_t *arena =
+        (zmq::msg_pool_arena_t*) pthread_getspecific (arena_key);
+    if (arena || !create_)
+        return arena;
+
+    //  Adopt an arena left behind by an exited thread if possible.
+    arenas_sync.lock ();
+    for (arena = arenas; arena; arena = arena->next_arena)
+        if (arena->orphaned.get ())
+            break;
+    if (arena)
+        arena->orphaned.sub (1);
+    else {
+        arena = new (std::nothrow) zmq::msg_pool_arena_t;
+        if (arena) {
+            for (int i = 0; i != zmq::msg_pool_classes; i++) {
+                arena->local [i] = NULL;
+                arena->local_count [i] = 0;
+            }
+            arena->hits.set (0);
+            arena->misses.set (0);
+            arena->orphaned.set (0);
+            arena->next_arena = arenas;
+            arenas = arena;
+        }
+    }
+    arenas_sync.unlock ();
+
+    if (arena) {
+        rc = pthread_setspecific (arena_key, arena);
+        posix_assert (rc);
+    }
+    return arena;
+}
+
+#else
+
+static zmq::msg_pool_arena_t *get_arena (bool)
+{
+    //  Thread caches are not supported on this platform.
+    return NULL;
+}
+
+#endif
+
+void *zmq::msg_pool_alloc (size_t size_)
+{
+    size_t total = sizeof (msg_pool_block_t) + size_;
+
+    //  Find the smallest size class the block fits into.
+    size_t size_class = 0;
+    while (size_class != msg_pool_classes && block_size (size_class) < total)
+        size_class++;
+
+    msg_pool_arena_t *arena = NULL;
+    if (users.get () && size_class != msg_pool_classes)
+        arena = get_arena (true);
+
+    //  Large blocks and blocks allocated while the pool is disabled are
+    //  passed straight to malloc.
+    if (!arena) {
+        msg_pool_block_t *block = (msg_pool_block_t*) malloc (total);
+        if (!block)
+            return NULL;
+        block->arena = NULL;
+        return block + 1;
+    }
+
+    msg_pool_block_t *block = arena->local [size_class];
+
+    //  If the local free list is empty, reclaim the blocks that were
+    //  released by other threads in the meantime. Anything beyond the
+    //  cache limit is returned to the system.
+    if (unlikely (!block)) {
+        block = arena->remote [size_class].xchg (NULL);
+        size_t count = 0;
+        msg_pool_block_t *last = NULL;
+        for (msg_pool_block_t *it = block; it; it = it->next) {
+            if (++count == max_cached (size_class)) {
+                last = it;
+                break;
+            }
+        }
+        if (last) {
+            free_blocks (last->next);
+            last->next = NULL;
+        }
+        arena->local_count [size_class] = (int) count;
+    }
+
+    if (likely (block != NULL)) {
+        arena->local [size_class] = block->next;
+        arena->local_count [size_class]--;
+        arena->hits.set (arena->hits.get () + 1);
+    }
+    else {
+        block = (msg_pool_block_t*) malloc (block_size (size_class));
+        if (!block)
+            return NULL;
+        block->arena = arena;
+        arena->misses.set (arena->misses.get () + 1);
+    }
+
+    block->size_class = size_class;
+    return block + 1;
+}
+
+void zmq::msg_pool_free (void *ptr_)
+{
+    msg_pool_block_t *block = ((msg_pool_block_t*) ptr_) - 1;
+    msg_pool_arena_t *arena = block->arena;
+    if (!arena) {
+        free (block);
+        return;
+    }
+
+    size_t size_class = block->size_class;
+
+    //  Once no context uses the pool, or the owner thread has exited, the
+    //  blocks are not cached any more. The owner thread frees whatever it
+    //  has cached as well.
+    if (unlikely (!users.get () || arena->orphaned.get ())) {
+        free (block);
+        if (arena == get_arena (false))
+            release_local (arena);
+        return;
+    }
+
+    //  Blocks released by the owner thread go to the local free list,
+    //  unless the cache for the size class is already full.
+    if (arena == get_arena (false)) {
+        if ((size_t) arena->local_count [size_class] >=
+              max_cached (size_class)) {
+            free (block);
+            return;
+        }
+        block->next = arena->local [size_class];
+        arena->local [size_class] = block;
+        arena->local_count [size_class]++;
+        return;
+    }
+
+    //  Hand the block back to the owner thread.
+    msg_pool_block_t *head = NULL;
+    while (true) {
+        block->next = head;
+        msg_pool_block_t *old = arena->remote [size_class].cas (head, block);
+        if (old == head)
+            break;
+        head = old;
+    }
+
+    //  If the owner thread has exited or the pool was disabled while the
+    //  block was being pushed, the list may already have been drained.
+    //  Drain it once more so that the block doesn't linger there.
+    if (unlikely (!users.get () || arena->orphaned.get ()))
+        free_blocks (arena->remote [size_class].xchg (NULL));
+}
+
+void zmq::msg_pool_enable ()
+{
+    users.add (1);
+}
+
+void zmq::msg_pool_disable ()
+{
+    if (users.sub (1))
+        return;
+
+    //  The last user is gone. Free the blocks the other threads have handed
+    //  back. The blocks in the local lists of the living threads are freed
+    //  by the threads themselves as soon as they release another block.
+    arenas_sync.lock ();
+    for (msg_pool_arena_t *arena = arenas; arena; arena = arena->next_arena)
+        release_remote (arena);
+    arenas_sync.unlock ();
+}
+
+void zmq::msg_pool_stats (uint32_t *hits_, uint32_t *misses_)
+{
+    //  The owner threads keep counting while the arenas are walked, so
+    //  the sums are a snapshot rather than an exact value.
+    *hits_ = 0;
+    *misses_ = 0;
+    arenas_sync.lock ();
+    for (msg_pool_arena_t *arena = arenas; arena; arena = arena->next_arena) {
+        *hits_ += arena->hits.get ();
+        *misses_ += arena->misses.get ();
+    }
+    arenas_sync.unlock ();
+}
@@ -0,0 +1,59 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MSG_POOL_HPP_INCLUDED__
+#define __ZMQ_MSG_POOL_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Size-classed, thread-caching allocator for message content blocks.
+    //  Each thread owns an arena with a private free list per size class.
+    //  Blocks released by other threads are handed back to the owning
+    //  arena via a lock-free list and reclaimed by the owner on its next
+    //  cache miss, up to the cache limit. The pool is process-wide: while
+    //  it is not enabled by any context, blocks are obtained directly from
+    //  malloc and the cached ones are freed. Blocks cached by a thread are
+    //  freed when the thread exits.
+
+    //  Allocates a block of at least size_ bytes. Returns NULL if there's
+    //  not enough memory.
+    void *msg_pool_alloc (size_t size_);
+
+    //  Releases a block allocated by msg_pool_alloc. The function can be
+    //  called from any thread.
+    void msg_pool_free (void *ptr_);
+
+    //  Enabling and disabling is reference-counted so that multiple
+    //  contexts can use the pool at the same time.
+    void msg_pool_enable ();
+    void msg_pool_disable ();
+
+    //  Returns the number of allocations served from the thread caches
+    //  and the number of allocations that had to be passed to malloc,
+    //  both modulo 2^32.
+    void msg_pool_stats (uint32_t *hits_, uint32_t *misses_);
+
+}
+
+#endif
@@ -19,410 +19,299 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#include <stdlib.h>
+#include <string.h>
 
 #include <new>
 #include <algorithm>
 
-#include "platform.hpp"
-#if defined ZMQ_HAVE_WINDOWS
-#include "windows.hpp"
-#endif
-
 #include "err.hpp"
 #include "pipe.hpp"
 #include "mtrie.hpp"
 
-zmq::mtrie_t::mtrie_t () :
-    pipes (0),
-    min (0),
-    count (0),
-    live_nodes (0)
+zmq::mtrie_t::mtrie_t ()
 {
 }
 
 zmq::mtrie_t::~mtrie_t ()
 {
-    if (pipes) {
-        delete pipes;
-        pipes = 0;
-    }
-
-    if (count == 1) {
-        zmq_assert (next.node);
-        delete next.node;
-        next.node = 0;
-    }
-    else if (count > 1) {
-        for (unsigned short i = 0; i != count; ++i)
-            if (next.table [i])
-                delete next.table [i];
-        free (next.table);
-    }
-}
-
-bool zmq::mtrie_t::add (unsigned char *prefix_, size_t size_, pipe_t *pipe_)
-{
-    return add_helper (prefix_, size_, pipe_);
+    for (nodes_t::size_type i = 0; i != chunks.size (); i++)
+        delete [] chunks [i];
 }
 
-bool zmq::mtrie_t::add_helper (unsigned char *prefix_, size_t size_,
-    pipe_t *pipe_)
+bool zmq::mtrie_t::add (unsigned char *prefix_, size_t size_, pipe_t *pipe_,
+    int slot_)
 {
-    //  We are at the node corresponding to the prefix. We are done.
-    if (!size_) {
-        bool result = !pipes;
-        if (!pipes) {
-            pipes = new (std::nothrow) pipes_t;
-            alloc_assert (pipes);
+    node_t *node = &root;
+    while (size_) {
+
+        //  If there's no child starting with the character, the rest of the
+        //  prefix goes into a new leaf.
+        edge_t *edge = find_edge (node, *prefix_);
+        if (!edge) {
+            node_t *child = alloc_node ();
+            child->label.assign (prefix_, size_);
+            add_edge (node, child);
+            node = child;
+            break;
         }
-        pipes->insert (pipe_);
-        return result;
-    }
 
-    unsigned char c = *prefix_;
-    if (c < min || c >= min + count) {
-
-        //  The character is out of range of currently handled
-        //  charcters. We have to extend the table.
-        if (!count) {
-            min = c;
-            count = 1;
-            next.node = NULL;
-        }
-        else if (count == 1) {
-            unsigned char oldc = min;
-            mtrie_t *oldp = next.node;
-            count = (min < c ? c - min : min - c) + 1;
-            next.table = (mtrie_t**)
-                malloc (sizeof (mtrie_t*) * count);
-            alloc_assert (next.table);
-            for (unsigned short i = 0; i != count; ++i)
-                next.table [i] = 0;
-            min = std::min (min, c);
-            next.table [oldc - min] = oldp;
-        }
-        else if (min < c) {
-
-            //  The new character is above the current character range.
-            unsigned short old_count = count;
-            count = c - min + 1;
-            next.table = (mtrie_t**) realloc (next.table,
-                sizeof (mtrie_t*) * count);
-            alloc_assert (next.table);
-            for (unsigned short i = old_count; i != count; i++)
-                next.table [i] = NULL;
+        //  Find out how much of the child's label the prefix matches.
+        node_t *child = edge->node;
+        const size_t len = child->label.size ();
+        size_t common = 1;
+        while (common < len && common < size_ &&
+              child->label [common] == prefix_ [common])
+            common++;
+
+        //  If the prefix diverges from the label, or ends in the middle of
+        //  it, split the child in two.
+        if (common < len) {
+            node_t *split = alloc_node ();
+            split->label.assign (child->label, 0, common);
+            child->label.erase (0, common);
+            add_edge (split, child);
+            edge->node = split;
+            child = split;
         }
-        else {
-
-            //  The new character is below the current character range.
-            unsigned short old_count = count;
-            count = (min + old_count) - c;
-            next.table = (mtrie_t**) realloc (next.table,
-                sizeof (mtrie_t*) * count);
-            alloc_assert (next.table);
-            memmove (next.table + min - c, next.table,
-                old_count * sizeof (mtrie_t*));
-            for (unsigned short i = 0; i != min - c; i++)
-                next.table [i] = NULL;
-            min = c;
-        }
-    }
 
-    //  If next node does not exist, create one.
-    if (count == 1) {
-        if (!next.node) {
-            next.node = new (std::nothrow) mtrie_t;
-            alloc_assert (next.node);
-            ++live_nodes;
-        }
-        return next.node->add_helper (prefix_ + 1, size_ - 1, pipe_);
-    }
-    else {
-        if (!next.table [c - min]) {
-            next.table [c - min] = new (std::nothrow) mtrie_t;
-            alloc_assert (next.table [c - min]);
-            ++live_nodes;
-        }
-        return next.table [c - min]->add_helper (prefix_ + 1, size_ - 1, pipe_);
+        node = child;
+        prefix_ += common;
+        size_ -= common;
     }
-}
 
+    //  We are at the node corresponding to the prefix.
+    const bool result = node->pipes.empty ();
+    if (!add_pipe (node, pipe_, slot_))
+        return false;
+    return result;
+}
 
 void zmq::mtrie_t::rm (pipe_t *pipe_,
     void (*func_) (unsigned char *data_, size_t size_, void *arg_),
     void *arg_)
 {
-    unsigned char *buff = NULL;
-    rm_helper (pipe_, &buff, 0, 0, func_, arg_);
-    free (buff);
+    blob_t buff;
+    rm_helper (&root, pipe_, buff, func_, arg_);
 }
 
-void zmq::mtrie_t::rm_helper (pipe_t *pipe_, unsigned char **buff_,
-    size_t buffsize_, size_t maxbuffsize_,
+void zmq::mtrie_t::rm_helper (node_t *node_, pipe_t *pipe_, blob_t &buff_,
     void (*func_) (unsigned char *data_, size_t size_, void *arg_),
     void *arg_)
 {
     //  Remove the subscription from this node.
-    if (pipes && pipes->erase (pipe_) && pipes->empty ()) {
-        func_ (*buff_, buffsize_, arg_);
-        delete pipes;
-        pipes = 0;
+    if (rm_pipe (node_, pipe_) && node_->pipes.empty ())
+        func_ ((unsigned char*) buff_.data (), buff_.size (), arg_);
+
+    //  Remove it from the subnodes, pruning the ones that are left
+    //  redundant. If a subnode is removed, the next one moves to its place.
+    edges_t::size_type i = 0;
+    while (i < node_->edges.size ()) {
+        node_t *child = node_->edges [i].node;
+        const size_t len = child->label.size ();
+        buff_.append (child->label);
+        rm_helper (child, pipe_, buff_, func_, arg_);
+        buff_.resize (buff_.size () - len);
+
+        const edges_t::size_type count = node_->edges.size ();
+        compact (node_, child);
+        if (node_->edges.size () == count)
+            i++;
     }
+}
 
-    //  Adjust the buffer.
-    if (buffsize_ >= maxbuffsize_) {
-        maxbuffsize_ = buffsize_ + 256;
-        *buff_ = (unsigned char*) realloc (*buff_, maxbuffsize_);
-        alloc_assert (*buff_);
+bool zmq::mtrie_t::rm (unsigned char *prefix_, size_t size_, pipe_t *pipe_)
+{
+    //  Find the node corresponding to the prefix, remembering the two nodes
+    //  above it. Those are the only ones the removal can make redundant.
+    node_t *grandparent = NULL;
+    node_t *parent = NULL;
+    node_t *node = &root;
+    while (size_) {
+        edge_t *edge = find_edge (node, *prefix_);
+        if (!edge)
+            return false;
+        node_t *child = edge->node;
+        const size_t len = child->label.size ();
+        if (len > size_ || memcmp (child->label.data (), prefix_, len) != 0)
+            return false;
+        grandparent = parent;
+        parent = node;
+        node = child;
+        prefix_ += len;
+        size_ -= len;
     }
 
-    //  If there are no subnodes in the trie, return.
-    if (count == 0)
-        return;
-
-    //  If there's one subnode (optimisation).
-    if (count == 1) {
-        (*buff_) [buffsize_] = min;
-        buffsize_++;
-        next.node->rm_helper (pipe_, buff_, buffsize_, maxbuffsize_,
-            func_, arg_);
-
-        //  Prune the node if it was made redundant by the removal
-        if (next.node->is_redundant ()) {
-            delete next.node;
-            next.node = 0;
-            count = 0;
-            --live_nodes;
-            zmq_assert (live_nodes == 0);
-        }
-        return;
-    }
+    if (!rm_pipe (node, pipe_))
+        return false;
+    const bool result = node->pipes.empty ();
 
-    //  If there are multiple subnodes.
-    //
-    //  New min non-null character in the node table after the removal
-    unsigned char new_min = min + count - 1;
-    //  New max non-null character in the node table after the removal
-    unsigned char new_max = min;
-    for (unsigned short c = 0; c != count; c++) {
-        (*buff_) [buffsize_] = min + c;
-        if (next.table [c]) {
-            next.table [c]->rm_helper (pipe_, buff_, buffsize_ + 1,
-                maxbuffsize_, func_, arg_);
-
-            //  Prune redundant nodes from the mtrie
-            if (next.table [c]->is_redundant ()) {
-                delete next.table [c];
-                next.table [c] = 0;
-
-                zmq_assert (live_nodes > 0);
-                --live_nodes;
-            }
-            else {
-                //  The node is not redundant, so it's a candidate for being
-                //  the new min/max node.
-                //
-                //  We loop through the node array from left to right, so the
-                //  first non-null, non-redundant node encountered is the new
-                //  minimum index. Conversely, the last non-redundant, non-null
-                //  node encountered is the new maximum index.
-                if (c + min < new_min)
-                    new_min = c + min;
-                if (c + min > new_max)
-                    new_max = c + min;
-            }
-        }
+    if (parent) {
+        compact (parent, node);
+        if (grandparent)
+            compact (grandparent, parent);
     }
 
-    zmq_assert (count > 1);
+    return result;
+}
 
-    //  Free the node table if it's no longer used.
-    if (live_nodes == 0) {
-        free (next.table);
-        next.table = NULL;
-        count = 0;
-    }
-    //  Compact the node table if possible
-    else if (live_nodes == 1) {
-        //  If there's only one live node in the table we can
-        //  switch to using the more compact single-node
-        //  representation
-        zmq_assert (new_min == new_max);
-        zmq_assert (new_min >= min && new_min < min + count);
-        mtrie_t *node = next.table [new_min - min];
-        zmq_assert (node);
-        free (next.table);
-        next.node = node;
-        count = 1;
-        min = new_min;
-    }
-    else if (new_min > min || new_max < min + count - 1) {
-        zmq_assert (new_max - new_min + 1 > 1);
+void zmq::mtrie_t::match (unsigned char *data_, size_t size_,
+    bitmap_t &slots_)
+{
+    node_t *current = &root;
+    while (true) {
 
-        mtrie_t **old_table = next.table;
-        zmq_assert (new_min > min || new_max < min + count - 1);
-        zmq_assert (new_min >= min);
-        zmq_assert (new_max <= min + count - 1);
-        zmq_assert (new_max - new_min + 1 < count);
+        //  Add the slots of the pipes attached to this node.
+        if (!current->bitmap.empty ())
+            bitmap_or (slots_, current->bitmap);
+        else
+            for (slots_t::size_type i = 0; i != current->slots.size (); i++)
+                bitmap_set (slots_, current->slots [i]);
 
-        count = new_max - new_min + 1;
-        next.table = (mtrie_t**) malloc (sizeof (mtrie_t*) * count);
-        alloc_assert (next.table);
+        //  If we are at the end of the message, there's nothing more to match.
+        if (!size_)
+            break;
 
-        memmove (next.table, old_table + (new_min - min),
-                 sizeof (mtrie_t*) * count);
-        free (old_table);
+        //  Find the subnode starting with the next character. The message
+        //  has to match the subnode's label in full.
+        edge_t *edge = find_edge (current, *data_);
+        if (!edge)
+            break;
+        node_t *next = edge->node;
+        const size_t len = next->label.size ();
+        if (len > size_ ||
+              memcmp (next->label.data () + 1, data_ + 1, len - 1) != 0)
+            break;
 
-        min = new_min;
+        current = next;
+        data_ += len;
+        size_ -= len;
     }
 }
 
-bool zmq::mtrie_t::rm (unsigned char *prefix_, size_t size_, pipe_t *pipe_)
+bool zmq::mtrie_t::add_pipe (node_t *node_, pipe_t *pipe_, int slot_)
 {
-    return rm_helper (prefix_, size_, pipe_);
+    pipes_t::iterator it = std::lower_bound (node_->pipes.begin (),
+        node_->pipes.end (), pipe_);
+    if (it != node_->pipes.end () && *it == pipe_)
+        return false;
+    node_->slots.insert (node_->slots.begin () + (it - node_->pipes.begin ()),
+        slot_);
+    node_->pipes.insert (it, pipe_);
+
+    //  Start keeping the bitmap once the node has enough pipes.
+    if (!node_->bitmap.empty ())
+        bitmap_set (node_->bitmap, slot_);
+    else
+    if (node_->pipes.size () >= bitmap_threshold)
+        for (slots_t::size_type i = 0; i != node_->slots.size (); i++)
+            bitmap_set (node_->bitmap, node_->slots [i]);
+    return true;
 }
 
-bool zmq::mtrie_t::rm_helper (unsigned char *prefix_, size_t size_,
-    pipe_t *pipe_)
+bool zmq::mtrie_t::rm_pipe (node_t *node_, pipe_t *pipe_)
 {
-    if (!size_) {
-        if (pipes) {
-            pipes_t::size_type erased = pipes->erase (pipe_);
-            zmq_assert (erased == 1);
-            if (pipes->empty ()) {
-                delete pipes;
-                pipes = 0;
-            }
-        }
-        return !pipes;
-    }
-
-    unsigned char c = *prefix_;
-    if (!count || c < min || c >= min + count)
+    pipes_t::iterator it = std::lower_bound (node_->pipes.begin (),
+        node_->pipes.end (), pipe_);
+    if (it == node_->pipes.end () || *it != pipe_)
         return false;
-
-    mtrie_t *next_node =
-        count == 1 ? next.node : next.table [c - min];
-
-    if (!next_node)
-        return false;
-
-    bool ret = next_node->rm_helper (prefix_ + 1, size_ - 1, pipe_);
-
-    if (next_node->is_redundant ()) {
-        delete next_node;
-        zmq_assert (count > 0);
-
-        if (count == 1) {
-            next.node = 0;
-            count = 0;
-            --live_nodes;
-            zmq_assert (live_nodes == 0);
-        }
-        else {
-            next.table [c - min] = 0;
-            zmq_assert (live_nodes > 1);
-            --live_nodes;
-
-            //  Compact the table if possible
-            if (live_nodes == 1) {
-                //  If there's only one live node in the table we can
-                //  switch to using the more compact single-node
-                //  representation
-                unsigned short i;
-                for (i = 0; i < count; ++i)
-                    if (next.table [i])
-                        break;
-
-                zmq_assert (i < count);
-                min += i;
-                count = 1;
-                mtrie_t *oldp = next.table [i];
-                free (next.table);
-                next.node = oldp;
-            }
-            else if (c == min) {
-                //  We can compact the table "from the left"
-                unsigned short i;
-                for (i = 1; i < count; ++i)
-                    if (next.table [i])
-                        break;
-
-                zmq_assert (i < count);
-                min += i;
-                count -= i;
-                mtrie_t **old_table = next.table;
-                next.table = (mtrie_t**) malloc (sizeof (mtrie_t*) * count);
-                alloc_assert (next.table);
-                memmove (next.table, old_table + i, sizeof (mtrie_t*) * count);
-                free (old_table);
-            }
-            else if (c == min + count - 1) {
-                //  We can compact the table "from the right"
-                unsigned short i;
-                for (i = 1; i < count; ++i)
-                    if (next.table [count - 1 - i])
-                        break;
-
-                zmq_assert (i < count);
-                count -= i;
-                mtrie_t **old_table = next.table;
-                next.table = (mtrie_t**) malloc (sizeof (mtrie_t*) * count);
-                alloc_assert (next.table);
-                memmove (next.table, old_table, sizeof (mtrie_t*) * count);
-                free (old_table);
-            }
-        }
+    slots_t::iterator slot = node_->slots.begin () +
+        (it - node_->pipes.begin ());
+    const int removed = *slot;
+    node_->slots.erase (slot);
+    node_->pipes.erase (it);
+
+    if (!node_->bitmap.empty ()) {
+        if (node_->pipes.size () < bitmap_threshold / 2)
+            bitmap_t ().swap (node_->bitmap);
+        else
+            bitmap_reset (node_->bitmap, removed);
     }
+    return true;
+}
 
-    return ret;
+zmq::mtrie_t::edge_t *zmq::mtrie_t::find_edge (node_t *node_,
+    unsigned char c_)
+{
+    edges_t &edges = node_->edges;
+    edges_t::size_type lo = 0;
+    edges_t::size_type hi = edges.size ();
+    while (lo < hi) {
+        const edges_t::size_type mid = (lo + hi) / 2;
+        if (edges [mid].c < c_)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo < edges.size () && edges [lo].c == c_)
+        return &edges [lo];
+    return NULL;
 }
 
-void zmq::mtrie_t::match (unsigned char *data_, size_t size_,
-    void (*func_) (pipe_t *pipe_, void *arg_), void *arg_)
+void zmq::mtrie_t::add_edge (node_t *node_, node_t *child_)
 {
-    mtrie_t *current = this;
-    while (true) {
+    edge_t edge;
+    edge.c = child_->label [0];
+    edge.node = child_;
+
+    edges_t::iterator it = node_->edges.begin ();
+    while (it != node_->edges.end () && it->c < edge.c)
+        ++it;
+    zmq_assert (it == node_->edges.end () || it->c != edge.c);
+    node_->edges.insert (it, edge);
+}
 
-        //  Signal the pipes attached to this node.
-        if (current->pipes) {
-            for (pipes_t::iterator it = current->pipes->begin ();
-                  it != current->pipes->end (); ++it)
-                func_ (*it, arg_);
-        }
+void zmq::mtrie_t::compact (node_t *node_, node_t *child_)
+{
+    if (!child_->pipes.empty ())
+        return;
 
-        //  If we are at the end of the message, there's nothing more to match.
-        if (!size_)
-            break;
+    //  Remove the child if nobody is interested in it or in any prefix
+    //  below it.
+    if (child_->edges.empty ()) {
+        edge_t *edge = find_edge (node_, child_->label [0]);
+        zmq_assert (edge && edge->node == child_);
+        node_->edges.erase (node_->edges.begin () +
+            (edge - &node_->edges [0]));
+        free_node (child_);
+        return;
+    }
 
-        //  If there are no subnodes in the trie, return.
-        if (current->count == 0)
-            break;
+    //  If the child is only a waypoint to a single grandchild, merge the
+    //  two. The merged node stays at the child's place, so the edge
+    //  leading to it does not change.
+    if (child_->edges.size () == 1) {
+        node_t *grandchild = child_->edges [0].node;
+        child_->label.append (grandchild->label);
+        child_->pipes.swap (grandchild->pipes);
+        child_->slots.swap (grandchild->slots);
+        child_->bitmap.swap (grandchild->bitmap);
+        child_->edges.swap (grandchild->edges);
+        free_node (grandchild);
+    }
+}
 
-        //  If there's one subnode (optimisation).
-		if (current->count == 1) {
-            if (data_ [0] != current->min)
-                break;
-            current = current->next.node;
-            data_++;
-            size_--;
-		    continue;
-		}
-
-		//  If there are multiple subnodes.
-        if (data_ [0] < current->min || data_ [0] >=
-              current->min + current->count)
-            break;
-        if (!current->next.table [data_ [0] - current->min])
-            break;
-        current = current->next.table [data_ [0] - current->min];
-        data_++;
-        size_--;
+zmq::mtrie_t::node_t *zmq::mtrie_t::alloc_node ()
+{
+    if (free_nodes.empty ()) {
+        node_t *chunk = new (std::nothrow) node_t [chunk_size];
+        alloc_assert (chunk);
+        chunks.push_back (chunk);
+        for (int i = chunk_size - 1; i >= 0; i--)
+            free_nodes.push_back (chunk + i);
     }
+    node_t *node = free_nodes.back ();
+    free_nodes.pop_back ();
+    return node;
 }
 
-bool zmq::mtrie_t::is_redundant () const
+void zmq::mtrie_t::free_node (node_t *node_)
 {
-    return !pipes && live_nodes == 0;
+    //  Give the memory held by the node back, the node itself stays in
+    //  the arena.
+    blob_t ().swap (node_->label);
+    pipes_t ().swap (node_->pipes);
+    slots_t ().swap (node_->slots);
+    bitmap_t ().swap (node_->bitmap);
+    edges_t ().swap (node_->edges);
+    free_nodes.push_back (node_);
 }
@@ -23,16 +23,25 @@
 #define __ZMQ_MTRIE_HPP_INCLUDED__
 
 #include <stddef.h>
-#include <set>
+#include <vector>
 
 #include "stdint.hpp"
+#include "blob.hpp"
+#include "bitmap.hpp"
 
 namespace zmq
 {
 
     class pipe_t;
 
-    //  Multi-trie. Each node in the trie is a set of pointers to pipes.
+    //  Multi-trie. Each node in the trie holds the pipes subscribed to the
+    //  prefix the node corresponds to. The trie is path-compressed: a chain
+    //  of nodes with no subscriptions and a single child is collapsed into
+    //  one node labelled with all the characters of the chain.
+    //
+    //  Along with each pipe the trie stores its slot in the distributor, so
+    //  that matching can produce a bitmap of slots. The trie never looks
+    //  inside the pipes.
 
     class mtrie_t
     {
@@ -43,7 +52,8 @@ namespace zmq
 
         //  Add key to the trie. Returns true if it's a new subscription
         //  rather than a duplicate.
-        bool add (unsigned char *prefix_, size_t size_, zmq::pipe_t *pipe_);
+        bool add (unsigned char *prefix_, size_t size_, zmq::pipe_t *pipe_,
+            int slot_);
 
         //  Remove all subscriptions for a specific peer from the trie.
         //  If there are no subscriptions left on some topics, invoke the
@@ -56,32 +66,83 @@ namespace zmq
         //  actually removed rather than de-duplicated.
         bool rm (unsigned char *prefix_, size_t size_, zmq::pipe_t *pipe_);
 
-        //  Signal all the matching pipes.
-        void match (unsigned char *data_, size_t size_,
-            void (*func_) (zmq::pipe_t *pipe_, void *arg_), void *arg_);
+        //  Set the slots of all the matching pipes in the bitmap.
+        void match (unsigned char *data_, size_t size_, bitmap_t &slots_);
 
     private:
 
-        bool add_helper (unsigned char *prefix_, size_t size_,
-            zmq::pipe_t *pipe_);
-        void rm_helper (zmq::pipe_t *pipe_, unsigned char **buff_,
-            size_t buffsize_, size_t maxbuffsize_,
+        struct node_t;
+
+        //  Link to a child node. The character is the first one of the
+        //  child's label, kept here so that the children can be searched
+        //  without touching them.
+        struct edge_t
+        {
+            unsigned char c;
+            node_t *node;
+        };
+
+        //  Pipes are kept sorted so that duplicates can be found quickly,
+        //  edges are kept sorted by their character.
+        typedef std::vector <zmq::pipe_t*> pipes_t;
+        typedef std::vector <int> slots_t;
+        typedef std::vector <edge_t> edges_t;
+
+        struct node_t
+        {
+            //  Characters on the way from the parent node to this one.
+            blob_t label;
+
+            //  Pipes subscribed to the prefix ending at this node and their
+            //  slots, in the same order.
+            pipes_t pipes;
+            slots_t slots;
+
+            //  Once there are many pipes subscribed, their slots are kept as
+            //  a bitmap as well, so that they can be matched all at once.
+            bitmap_t bitmap;
+
+            edges_t edges;
+        };
+
+        //  Number of pipes in a node that makes it keep the bitmap.
+        enum { bitmap_threshold = 32 };
+
+        //  Add or remove a pipe from the node. Return true if the pipe was
+        //  actually added or removed.
+        static bool add_pipe (node_t *node_, zmq::pipe_t *pipe_, int slot_);
+        static bool rm_pipe (node_t *node_, zmq::pipe_t *pipe_);
+
+        //  Returns the edge starting with the character, NULL if there's
+        //  none.
+        static edge_t *find_edge (node_t *node_, unsigned char c_);
+
+        //  Adds an edge to the node, keeping the edges sorted.
+        static void add_edge (node_t *node_, node_t *child_);
+
+        void rm_helper (node_t *node_, zmq::pipe_t *pipe_, blob_t &buff_,
             void (*func_) (unsigned char *data_, size_t size_, void *arg_),
             void *arg_);
-        bool rm_helper (unsigned char *prefix_, size_t size_,
-            zmq::pipe_t *pipe_);
-        bool is_redundant () const;
-
-        typedef std::set <zmq::pipe_t*> pipes_t;
-        pipes_t *pipes;
-
-        unsigned char min;
-        unsigned short count;
-        unsigned short live_nodes;
-        union {
-            class mtrie_t *node;
-            class mtrie_t **table;
-        } next;
+
+        //  Restores the compression after the subscriptions of the child
+        //  node were removed. The child is either removed, if it has no
+        //  subscriptions and no children, or merged with its only child.
+        void compact (node_t *node_, node_t *child_);
+
+        //  Nodes are allocated from an arena so that they are packed closely
+        //  in memory and are not returned to the heap one by one.
+        node_t *alloc_node ();
+        void free_node (node_t *node_);
+
+        //  Number of nodes in each chunk of the arena.
+        enum { chunk_size = 256 };
+
+        typedef std::vector <node_t*> nodes_t;
+        nodes_t chunks;
+        nodes_t free_nodes;
+
+        //  The root node. Its label is always empty.
+        node_t root;
 
         mtrie_t (const mtrie_t&);
         const mtrie_t &operator = (const mtrie_t&);
@@ -65,7 +65,8 @@ zmq::pipe_t::pipe_t (object_t *parent_, upipe_t *inpipe_, upipe_t *outpipe_,
     peer (NULL),
     sink (NULL),
     state (active),
-    delay (delay_)
+    delay (delay_),
+    slot (-1)
 {
 }
 
@@ -92,11 +93,26 @@ void zmq::pipe_t::set_identity (const blob_t &identity_)
     identity = identity_;
 }
 
-zmq::blob_t zmq::pipe_t::get_identity ()
+const zmq::blob_t &zmq::pipe_t::get_identity ()
 {
     return identity;
 }
 
+void zmq::pipe_t::set_slot (int slot_)
+{
+    slot = slot_;
+}
+
+int zmq::pipe_t::get_slot ()
+{
+    return slot;
+}
+
+int zmq::pipe_t::get_hwm ()
+{
+    return hwm;
+}
+
 bool zmq::pipe_t::check_read ()
 {
     if (unlikely (!in_active || (state != active && state != pending)))
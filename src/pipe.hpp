@@ -77,7 +77,15 @@ namespace zmq
 
         //  Pipe endpoint can store an opaque ID to be used by its clients.
         void set_identity (const blob_t &identity_);
-        blob_t get_identity ();
+        const blob_t &get_identity ();
+
+        //  Slot number assigned to the pipe by the distributor. It does not
+        //  change while the pipe is attached to the distributor.
+        void set_slot (int slot_);
+        int get_slot ();
+
+        //  Returns the high watermark of the outbound pipe, 0 if unlimited.
+        int get_hwm ();
 
         //  Returns true if there is at least one message to read in the pipe.
         bool check_read ();
@@ -191,6 +199,9 @@ namespace zmq
         //  Identity of the writer. Used uniquely by the reader side.
         blob_t identity;
 
+        //  Slot of the pipe in the distributor, -1 if there's none.
+        int slot;
+
         //  Returns true if the message is delimiter; false otherwise.
         static bool is_delimiter (msg_t &msg_);
 
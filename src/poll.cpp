@@ -123,6 +123,9 @@ void zmq::poll_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Apply the message releases deferred while handling the events.
+        flush_releases ();
+
         //  Wait for events.
         int rc = poll (&pollset [0], pollset.size (), timeout ? timeout : -1);
         if (rc == -1) {
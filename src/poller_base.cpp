@@ -21,8 +21,15 @@
 #include "poller_base.hpp"
 #include "i_poll_events.hpp"
 #include "err.hpp"
-
-zmq::poller_base_t::poller_base_t ()
+#include "msg.hpp"
+
+zmq::poller_base_t::poller_base_t () :
+    busy_poll (0),
+    busy_iterations (0),
+    idle_iterations (0),
+    edge_triggered (false),
+    so_busy_poll (false),
+    batch_releases (false)
 {
 }
 
@@ -45,24 +52,46 @@ void zmq::poller_base_t::adjust_load (int amount_)
         load.sub (-amount_);
 }
 
+void zmq::poller_base_t::set_busy_poll (int busy_us_, bool so_busy_poll_)
+{
+    busy_poll = busy_us_;
+    so_busy_poll = so_busy_poll_;
+}
+
+int zmq::poller_base_t::get_so_busy_poll ()
+{
+    return so_busy_poll ? busy_poll : 0;
+}
+
+void zmq::poller_base_t::set_edge_triggered (bool edge_triggered_)
+{
+    edge_triggered = edge_triggered_;
+}
+
+void zmq::poller_base_t::set_batch_releases (bool batch_releases_)
+{
+    batch_releases = batch_releases_;
+}
+
+uint32_t zmq::poller_base_t::get_busy_iterations ()
+{
+    return busy_iterations.get ();
+}
+
+uint32_t zmq::poller_base_t::get_idle_iterations ()
+{
+    return idle_iterations.get ();
+}
+
 void zmq::poller_base_t::add_timer (int timeout_, i_poll_events *sink_, int id_)
 {
-    uint64_t expiration = clock.now_ms () + timeout_;
-    timer_info_t info = {sink_, id_};
-    timers.insert (timers_t::value_type (expiration, info));
+    timers.add (clock.now_ms (), timeout_, sink_, id_);
 }
 
 void zmq::poller_base_t::cancel_timer (i_poll_events *sink_, int id_)
 {
-    //  Complexity of this operation is O(n). We assume it is rarely used.
-    for (timers_t::iterator it = timers.begin (); it != timers.end (); ++it)
-        if (it->second.sink == sink_ && it->second.id == id_) {
-            timers.erase (it);
-            return;
-        }
-
-    //  Timer not found.
-    zmq_assert (false);
+    const bool found = timers.cancel (sink_, id_);
+    zmq_assert (found);
 }
 
 uint64_t zmq::poller_base_t::execute_timers ()
@@ -71,29 +100,17 @@ uint64_t zmq::poller_base_t::execute_timers ()
     if (timers.empty ())
         return 0;
 
-    //  Get the current time.
-    uint64_t current = clock.now_ms ();
-
-    //   Execute the timers that are already due.
-    timers_t::iterator it = timers.begin ();
-    while (it != timers.end ()) {
-
-        //  If we have to wait to execute the item, same will be true about
-        //  all the following items (multimap is sorted). Thus we can stop
-        //  checking the subsequent timers and return the time to wait for
-        //  the next timer (at least 1ms).
-        if (it->first > current)
-            return it->first - current;
-
-        //  Trigger the timer.
-        it->second.sink->timer_event (it->second.id);
+    //  Execute the timers that are already due and return the time to wait
+    //  for the next one.
+    return timers.execute (clock.now_ms ());
+}
 
-        //  Remove it from the list of active timers.
-        timers_t::iterator o = it;
-        ++it;
-        timers.erase (o);
-    }
+void zmq::poller_base_t::flush_releases ()
+{
+    if (!batch_releases)
+        return;
 
-    //  There are no more timers.
-    return 0;
+    //  The first call is made by the poller thread once it's running.
+    msg_t::batch_releases ();
+    msg_t::flush_releases ();
 }
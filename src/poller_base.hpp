@@ -21,10 +21,9 @@
 #ifndef __ZMQ_POLLER_BASE_HPP_INCLUDED__
 #define __ZMQ_POLLER_BASE_HPP_INCLUDED__
 
-#include <map>
-
 #include "clock.hpp"
 #include "atomic_counter.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -50,6 +49,33 @@ namespace zmq
         //  Cancel the timer created by sink_ object with ID equal to id_.
         void cancel_timer (zmq::i_poll_events *sink_, int id_);
 
+        //  Makes the poller keep polling without blocking for busy_us_
+        //  microseconds after each batch of events. If so_busy_poll_ is
+        //  true, the same value should be applied to the sockets handled by
+        //  the poller using SO_BUSY_POLL. Must be called before the poller
+        //  is started. Pollers other than epoll ignore the setting.
+        void set_busy_poll (int busy_us_, bool so_busy_poll_);
+
+        //  Returns the SO_BUSY_POLL value to use for the sockets handled by
+        //  the poller, 0 meaning none.
+        int get_so_busy_poll ();
+
+        //  Allows the poller to use edge-triggered notifications for the
+        //  fds whose owners ask for it. Must be called before the poller is
+        //  started. Pollers other than epoll ignore the setting.
+        void set_edge_triggered (bool edge_triggered_);
+
+        //  Makes the poller thread batch the reference count decrements of
+        //  the messages it closes, see msg_t::batch_releases. Must be called
+        //  before the poller is started.
+        void set_batch_releases (bool batch_releases_);
+
+        //  Returns the number of non-blocking and blocking waits for events,
+        //  respectively, modulo 2^32. These functions can be invoked from
+        //  a different thread.
+        uint32_t get_busy_iterations ();
+        uint32_t get_idle_iterations ();
+
     protected:
 
         //  Called by individual poller implementations to manage the load.
@@ -59,24 +85,41 @@ namespace zmq
         //  to wait to match the next timer or 0 meaning "no timers".
         uint64_t execute_timers ();
 
+        //  Applies the message releases deferred by the poller thread.
+        //  Called by individual poller implementations before waiting for
+        //  events.
+        void flush_releases ();
+
+        //  Busy polling window in microseconds, 0 if busy polling is off.
+        int busy_poll;
+
+        //  Number of waits for events that did not block and that did,
+        //  respectively. Updated by the poller thread only, so a plain
+        //  store is enough, but read by other threads.
+        atomic_counter_t busy_iterations;
+        atomic_counter_t idle_iterations;
+
+        //  If true, edge-triggered notifications may be used.
+        bool edge_triggered;
+
     private:
 
         //  Clock instance private to this I/O thread.
         clock_t clock;
 
-        //  List of active timers.
-        struct timer_info_t
-        {
-            zmq::i_poll_events *sink;
-            int id;
-        };
-        typedef std::multimap <uint64_t, timer_info_t> timers_t;
-        timers_t timers;
+        //  Active timers.
+        timer_wheel_t timers;
 
         //  Load of the poller. Currently the number of file descriptors
         //  registered.
         atomic_counter_t load;
 
+        //  If true, SO_BUSY_POLL is set on the sockets handled by the poller.
+        bool so_busy_poll;
+
+        //  If true, the poller thread batches its message releases.
+        bool batch_releases;
+
         poller_base_t (const poller_base_t&);
         const poller_base_t &operator = (const poller_base_t&);
     };
@@ -0,0 +1,268 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+
+#include "prefix_matcher.hpp"
+#include "config.hpp"
+#include "err.hpp"
+
+#if (defined __x86_64__ && (defined __clang__ || __GNUC__ > 4 || \
+      (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)))
+#define ZMQ_HAVE_CRC32_HASH
+#include <cpuid.h>
+#include <nmmintrin.h>
+#endif
+
+static uint32_t hash_scalar (const uint64_t *words_)
+{
+    const uint64_t k1 = (uint64_t) 0x9e3779b9 << 32 | 0x7f4a7c15;
+    const uint64_t k2 = (uint64_t) 0xff51afd7 << 32 | 0xed558ccd;
+    const uint64_t h = (words_ [0] ^ (words_ [1] * k1)) * k2;
+    return (uint32_t) (h >> 32 ^ h);
+}
+
+#if defined ZMQ_HAVE_CRC32_HASH
+
+//  The function is compiled for SSE4.2 regardless of the compiler flags. It
+//  is only ever called after checking that the CPU supports it.
+__attribute__ ((target ("sse4.2")))
+static uint32_t hash_crc32 (const uint64_t *words_)
+{
+    return (uint32_t) _mm_crc32_u64 (_mm_crc32_u64 (0, words_ [0]),
+        words_ [1]);
+}
+
+static bool has_crc32 ()
+{
+    unsigned int eax, ebx, ecx, edx;
+    if (!__get_cpuid (1, &eax, &ebx, &ecx, &edx))
+        return false;
+    return (ecx & bit_SSE4_2) != 0;
+}
+
+#endif
+
+//  Returns the word whose in-memory representation starts with the bytes
+//  supplied, followed by zeroes. Fewer than eight bytes must be supplied.
+static uint64_t load_partial (const unsigned char *data_, size_t size_)
+{
+    const uint16_t one = 1;
+    unsigned char first;
+    memcpy (&first, &one, 1);
+    const bool little_endian = first == 1;
+
+    uint64_t word = 0;
+    for (size_t i = 0; i != size_; i++)
+        word |= (uint64_t) data_ [i] << (little_endian ? i * 8 : 56 - i * 8);
+    return word;
+}
+
+zmq::prefix_matcher_t::prefix_matcher_t () :
+    lengths_count (0),
+    count (0),
+    long_count (0),
+    hash (hash_scalar)
+{
+#if defined ZMQ_HAVE_CRC32_HASH
+    if (has_crc32 ())
+        hash = hash_crc32;
+#endif
+
+    for (size_t i = 0; i <= max_prefix_size; i++) {
+        tables [i].count = 0;
+        unsigned char mask [max_prefix_size];
+        memset (mask, 0xff, i);
+        memset (mask + i, 0, max_prefix_size - i);
+        memcpy (masks [i].words, mask, sizeof mask);
+    }
+}
+
+zmq::prefix_matcher_t::~prefix_matcher_t ()
+{
+}
+
+void zmq::prefix_matcher_t::add (const unsigned char *prefix_, size_t size_)
+{
+    if (size_ > max_prefix_size) {
+        long_count++;
+        return;
+    }
+
+    count++;
+    if (size_ == 0) {
+        tables [0].count++;
+        return;
+    }
+
+    key_t key;
+    make_key (&key, prefix_, size_);
+    insert (tables [size_], key, hash (key.words));
+    if (tables [size_].count == 1)
+        update_lengths ();
+}
+
+void zmq::prefix_matcher_t::rm (const unsigned char *prefix_, size_t size_)
+{
+    if (size_ > max_prefix_size) {
+        zmq_assert (long_count > 0);
+        long_count--;
+        return;
+    }
+
+    zmq_assert (count > 0);
+    count--;
+    if (size_ == 0) {
+        zmq_assert (tables [0].count > 0);
+        tables [0].count--;
+        return;
+    }
+
+    key_t key;
+    make_key (&key, prefix_, size_);
+    slot_t *slot = find (tables [size_], key, hash (key.words));
+    zmq_assert (slot);
+    erase (tables [size_], slot);
+    if (tables [size_].count == 0)
+        update_lengths ();
+}
+
+bool zmq::prefix_matcher_t::usable () const
+{
+    return long_count == 0 && count >= prefix_matcher_min_subscriptions &&
+        lengths_count <= prefix_matcher_max_lengths;
+}
+
+bool zmq::prefix_matcher_t::check (const unsigned char *data_, size_t size_)
+{
+    //  Empty subscription matches all the messages.
+    if (tables [0].count)
+        return true;
+
+    //  Leading bytes of the message, padded with zeroes. They are kept in
+    //  registers rather than in a key_t so that the CPU does not have to
+    //  load a whole key that was stored a word at a time.
+    uint64_t first;
+    uint64_t second;
+    if (size_ >= sizeof (uint64_t)) {
+        memcpy (&first, data_, sizeof (uint64_t));
+        if (size_ >= max_prefix_size)
+            memcpy (&second, data_ + sizeof (uint64_t), sizeof (uint64_t));
+        else
+            second = load_partial (data_ + sizeof (uint64_t),
+                size_ - sizeof (uint64_t));
+    }
+    else {
+        first = load_partial (data_, size_);
+        second = 0;
+    }
+
+    //  Look up the leading bytes of the message in the table of each
+    //  subscription length.
+    for (size_t i = 0; i != lengths_count; i++) {
+        const size_t len = lengths [i];
+        if (len > size_)
+            break;
+        key_t key;
+        key.words [0] = first & masks [len].words [0];
+        key.words [1] = second & masks [len].words [1];
+        if (find (tables [len], key, hash (key.words)))
+            return true;
+    }
+    return false;
+}
+
+void zmq::prefix_matcher_t::make_key (key_t *key_, const unsigned char *data_,
+    size_t size_)
+{
+    unsigned char buf [max_prefix_size];
+    memcpy (buf, data_, size_);
+    memset (buf + size_, 0, max_prefix_size - size_);
+    memcpy (key_->words, buf, sizeof buf);
+}
+
+zmq::prefix_matcher_t::slot_t *zmq::prefix_matcher_t::find (table_t &table_,
+    const key_t &key_, uint32_t hash_)
+{
+    if (table_.slots.empty ())
+        return NULL;
+
+    const size_t mask = table_.slots.size () - 1;
+    for (size_t pos = hash_ & mask; table_.slots [pos].used;
+          pos = (pos + 1) & mask) {
+        slot_t &slot = table_.slots [pos];
+        if (slot.hash == hash_ && slot.key.words [0] == key_.words [0] &&
+              slot.key.words [1] == key_.words [1])
+            return &slot;
+    }
+    return NULL;
+}
+
+void zmq::prefix_matcher_t::insert (table_t &table_, const key_t &key_,
+    uint32_t hash_)
+{
+    //  Keep the table at most half full.
+    if ((table_.count + 1) * 2 > table_.slots.size ()) {
+        std::vector <slot_t> old;
+        old.swap (table_.slots);
+        slot_t empty;
+        memset (&empty, 0, sizeof empty);
+        table_.slots.resize (old.empty () ? 16 : old.size () * 2, empty);
+        table_.count = 0;
+        for (size_t i = 0; i != old.size (); i++)
+            if (old [i].used)
+                insert (table_, old [i].key, old [i].hash);
+    }
+
+    const size_t mask = table_.slots.size () - 1;
+    size_t pos = hash_ & mask;
+    while (table_.slots [pos].used)
+        pos = (pos + 1) & mask;
+    table_.slots [pos].key = key_;
+    table_.slots [pos].hash = hash_;
+    table_.slots [pos].used = true;
+    table_.count++;
+}
+
+void zmq::prefix_matcher_t::erase (table_t &table_, slot_t *slot_)
+{
+    //  Move the following slots of the cluster back, unless that would
+    //  put them before the position they hash to.
+    const size_t mask = table_.slots.size () - 1;
+    size_t hole = slot_ - &table_.slots [0];
+    size_t pos = (hole + 1) & mask;
+    while (table_.slots [pos].used) {
+        const size_t home = table_.slots [pos].hash & mask;
+        if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+            table_.slots [hole] = table_.slots [pos];
+            hole = pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    table_.slots [hole].used = false;
+    table_.count--;
+}
+
+void zmq::prefix_matcher_t::update_lengths ()
+{
+    lengths_count = 0;
+    for (size_t i = 1; i <= max_prefix_size; i++)
+        if (tables [i].count)
+            lengths [lengths_count++] = (unsigned char) i;
+}
@@ -0,0 +1,120 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_PREFIX_MATCHER_HPP_INCLUDED__
+#define __ZMQ_PREFIX_MATCHER_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <vector>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    //  Set of subscriptions matched by hashing the leading bytes of the
+    //  message, one lookup per distinct subscription length. It is meant
+    //  to be used instead of the trie when there are many subscriptions,
+    //  all of them short and of a few distinct lengths, ie. when the trie
+    //  is wide and shallow. The matcher does not count duplicates, the
+    //  trie does that.
+
+    class prefix_matcher_t
+    {
+    public:
+
+        //  Subscriptions longer than this make the matcher unusable.
+        enum { max_prefix_size = 16 };
+
+        prefix_matcher_t ();
+        ~prefix_matcher_t ();
+
+        //  Add a new subscription.
+        void add (const unsigned char *prefix_, size_t size_);
+
+        //  Remove an existing subscription.
+        void rm (const unsigned char *prefix_, size_t size_);
+
+        //  Returns true if the current subscriptions are matched faster by
+        //  the matcher than by the trie.
+        bool usable () const;
+
+        //  Check whether the message matches any of the subscriptions.
+        //  Must not be called if there are subscriptions longer than
+        //  max_prefix_size.
+        bool check (const unsigned char *data_, size_t size_);
+
+    private:
+
+        //  Subscription padded with zeroes to max_prefix_size bytes.
+        struct key_t
+        {
+            uint64_t words [2];
+        };
+
+        struct slot_t
+        {
+            key_t key;
+            uint32_t hash;
+            bool used;
+        };
+
+        //  Open addressing hash table holding the subscriptions of a single
+        //  length, kept at most half full.
+        struct table_t
+        {
+            std::vector <slot_t> slots;
+            size_t count;
+        };
+
+        static void make_key (key_t *key_, const unsigned char *data_,
+            size_t size_);
+        slot_t *find (table_t &table_, const key_t &key_, uint32_t hash_);
+        void insert (table_t &table_, const key_t &key_, uint32_t hash_);
+        void erase (table_t &table_, slot_t *slot_);
+        void update_lengths ();
+
+        //  Tables of subscriptions indexed by their length. The table of
+        //  empty subscriptions has no slots, just the count.
+        table_t tables [max_prefix_size + 1];
+
+        //  Masks leaving the given number of leading bytes of a key.
+        key_t masks [max_prefix_size + 1];
+
+        //  Non-zero lengths having any subscriptions, in ascending order.
+        unsigned char lengths [max_prefix_size];
+        size_t lengths_count;
+
+        //  Number of subscriptions up to max_prefix_size bytes long.
+        size_t count;
+
+        //  Number of subscriptions longer than max_prefix_size.
+        size_t long_count;
+
+        //  Hash function. CRC32 instruction is used if the CPU supports it,
+        //  a multiplicative hash otherwise.
+        uint32_t (*hash) (const uint64_t *words_);
+
+        prefix_matcher_t (const prefix_matcher_t&);
+        const prefix_matcher_t &operator = (const prefix_matcher_t&);
+    };
+
+}
+
+#endif
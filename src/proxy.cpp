@@ -19,6 +19,8 @@
 */
 
 #include <stddef.h>
+#include <string.h>
+#include <string>
 #include "platform.hpp"
 #include "proxy.hpp"
 #include "likely.hpp"
@@ -49,102 +51,289 @@
 // These headers end up pulling in zmq.h somewhere in their include
 // dependency chain
 #include "socket_base.hpp"
+#include "config.hpp"
+#include "clock.hpp"
+#include "stdint.hpp"
 #include "err.hpp"
 
 // zmq.h must be included *after* poll.h for AIX to build properly
 #include "../include/zmq.h"
 
 
-int zmq::proxy (
-    class socket_base_t *frontend_,
-    class socket_base_t *backend_,
-    class socket_base_t *capture_)
+//  One direction of the traffic passing through the proxy.
+struct direction_t
+{
+    zmq::socket_base_t *from;
+    zmq::socket_base_t *to;
+
+    //  If true, the destination didn't accept the first frame of the
+    //  message in 'msg'. No more messages are read from the source till the
+    //  destination becomes writable again.
+    bool stalled;
+    zmq::msg_t msg;
+
+    //  Statistics reported via the control socket. Time spent stalled is
+    //  in microseconds; the current stall, if any, started at
+    //  'stalled_since'.
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t stalled_us;
+    uint64_t stalled_since;
+};
+
+static int init_direction (direction_t *dir_, zmq::socket_base_t *from_,
+    zmq::socket_base_t *to_)
+{
+    dir_->from = from_;
+    dir_->to = to_;
+    dir_->stalled = false;
+    dir_->frames = 0;
+    dir_->bytes = 0;
+    dir_->stalled_us = 0;
+    dir_->stalled_since = 0;
+    return dir_->msg.init ();
+}
+
+static uint64_t stalled_us (direction_t *dir_)
+{
+    if (!dir_->stalled)
+        return dir_->stalled_us;
+    return dir_->stalled_us + zmq::clock_t::now_us () - dir_->stalled_since;
+}
+
+//  Sends a copy of the frame to the capture socket, if any.
+static int capture (zmq::socket_base_t *capture_, zmq::msg_t &msg_,
+    bool more_)
+{
+    if (!capture_)
+        return 0;
+
+    zmq::msg_t ctrl;
+    int rc = ctrl.init ();
+    if (unlikely (rc < 0))
+        return -1;
+    rc = ctrl.copy (msg_);
+    if (unlikely (rc < 0))
+        return -1;
+    return capture_->send (&ctrl, more_? ZMQ_SNDMORE: 0);
+}
+
+//  Moves up to proxy_batch_size messages in the given direction, stopping
+//  early if the source has no more messages or the destination is full.
+static int forward (direction_t *dir_, zmq::socket_base_t *capture_)
+{
+    for (int i = 0; i != zmq::proxy_batch_size; i++) {
+
+        //  Unless there's a message left over from the last time, get one.
+        if (!dir_->stalled) {
+            int rc = dir_->from->recv (&dir_->msg, ZMQ_DONTWAIT);
+            if (rc < 0)
+                return errno == EAGAIN ? 0 : -1;
+            rc = capture (capture_, dir_->msg,
+                dir_->msg.flags () & zmq::msg_t::more);
+            if (unlikely (rc < 0))
+                return -1;
+        }
+
+        //  The destination can refuse only the first frame of a message.
+        //  Once it's accepted, the rest of the message is sure to follow.
+        bool more = dir_->msg.flags () & zmq::msg_t::more;
+        size_t size = dir_->msg.size ();
+        int rc = dir_->to->send (&dir_->msg,
+            (more? ZMQ_SNDMORE: 0) | ZMQ_DONTWAIT);
+        if (rc < 0) {
+            if (errno != EAGAIN)
+                return -1;
+            if (!dir_->stalled) {
+                dir_->stalled = true;
+                dir_->stalled_since = zmq::clock_t::now_us ();
+            }
+            return 0;
+        }
+        if (dir_->stalled) {
+            dir_->stalled = false;
+            dir_->stalled_us += zmq::clock_t::now_us () - dir_->stalled_since;
+        }
+        dir_->frames++;
+        dir_->bytes += size;
+
+        while (more) {
+            rc = dir_->from->recv (&dir_->msg, 0);
+            if (unlikely (rc < 0))
+                return -1;
+            more = dir_->msg.flags () & zmq::msg_t::more;
+            rc = capture (capture_, dir_->msg, more);
+            if (unlikely (rc < 0))
+                return -1;
+            size = dir_->msg.size ();
+            rc = dir_->to->send (&dir_->msg, more? ZMQ_SNDMORE: 0);
+            if (unlikely (rc < 0))
+                return -1;
+            dir_->frames++;
+            dir_->bytes += size;
+        }
+    }
+    return 0;
+}
+
+//  Sends the statistics as a multipart message of 64-bit integers in the
+//  host byte order.
+static int send_statistics (zmq::socket_base_t *control_,
+    direction_t *requests_, direction_t *replies_)
+{
+    uint64_t values [] = {
+        requests_->frames, requests_->bytes, stalled_us (requests_),
+        replies_->frames, replies_->bytes, stalled_us (replies_)
+    };
+    const int count = sizeof (values) / sizeof (values [0]);
+    for (int i = 0; i != count; i++) {
+        zmq::msg_t msg;
+        int rc = msg.init_size (sizeof (uint64_t));
+        if (unlikely (rc < 0))
+            return -1;
+        memcpy (msg.data (), &values [i], sizeof (uint64_t));
+        rc = control_->send (&msg, i + 1 != count ? ZMQ_SNDMORE : 0);
+        if (unlikely (rc < 0)) {
+            msg.close ();
+            return -1;
+        }
+    }
+    return 0;
+}
+
+//  Executes a command from the control socket. Returns 1 if the proxy
+//  should terminate.
+static int process_command (zmq::socket_base_t *control_, bool *paused_,
+    direction_t *requests_, direction_t *replies_)
 {
-    msg_t msg;
+    zmq::msg_t msg;
     int rc = msg.init ();
-    if (rc != 0)
+    if (unlikely (rc < 0))
         return -1;
+    rc = control_->recv (&msg, ZMQ_DONTWAIT);
+    if (rc < 0) {
+        msg.close ();
+        return errno == EAGAIN ? 0 : -1;
+    }
+
+    std::string command ((char*) msg.data (), msg.size ());
+    while (msg.flags () & zmq::msg_t::more) {
+        rc = control_->recv (&msg, 0);
+        if (unlikely (rc < 0)) {
+            msg.close ();
+            return -1;
+        }
+    }
+    rc = msg.close ();
+    errno_assert (rc == 0);
 
-    //  The algorithm below assumes ratio of requests and replies processed
-    //  under full load to be 1:1.
+    if (command == "STATISTICS")
+        return send_statistics (control_, requests_, replies_);
 
-    int more;
-    size_t moresz;
+    bool terminate = false;
+    if (command == "PAUSE")
+        *paused_ = true;
+    else
+    if (command == "RESUME")
+        *paused_ = false;
+    else
+    if (command == "TERMINATE")
+        terminate = true;
+
+    //  A REP socket has to reply before it can get the next command.
+    int type;
+    size_t type_size = sizeof (type);
+    rc = control_->getsockopt (ZMQ_TYPE, &type, &type_size);
+    errno_assert (rc == 0);
+    if (type == ZMQ_REP) {
+        rc = msg.init ();
+        if (unlikely (rc < 0))
+            return -1;
+        rc = control_->send (&msg, 0);
+        if (unlikely (rc < 0)) {
+            msg.close ();
+            return -1;
+        }
+    }
+    return terminate ? 1 : 0;
+}
+
+static int proxy_loop (direction_t *requests_, direction_t *replies_,
+    zmq::socket_base_t *capture_, zmq::socket_base_t *control_)
+{
     zmq_pollitem_t items [] = {
-        { frontend_, 0, ZMQ_POLLIN, 0 },
-        { backend_, 0, ZMQ_POLLIN, 0 }
+        { requests_->from, 0, 0, 0 },
+        { replies_->from, 0, 0, 0 },
+        { control_, 0, ZMQ_POLLIN, 0 }
     };
+    bool paused = false;
     while (true) {
-        //  Wait while there are either requests or replies to process.
-        rc = zmq_poll (&items [0], 2, -1);
+
+        //  Read from a socket only if its peer is writable. If it is not,
+        //  wait till it becomes writable instead. While paused, wait for
+        //  the control commands only.
+        items [0].events = paused ? 0 :
+            (requests_->stalled ? 0 : ZMQ_POLLIN) |
+            (replies_->stalled ? ZMQ_POLLOUT : 0);
+        items [1].events = paused ? 0 :
+            (replies_->stalled ? 0 : ZMQ_POLLIN) |
+            (requests_->stalled ? ZMQ_POLLOUT : 0);
+        int rc = zmq_poll (&items [0], control_ ? 3 : 2, -1);
         if (unlikely (rc < 0))
             return -1;
 
-        //  Process a request
-        if (items [0].revents & ZMQ_POLLIN) {
-            while (true) {
-                rc = frontend_->recv (&msg, 0);
-                if (unlikely (rc < 0))
-                    return -1;
-
-                moresz = sizeof more;
-                rc = frontend_->getsockopt (ZMQ_RCVMORE, &more, &moresz);
-                if (unlikely (rc < 0))
-                    return -1;
-
-                //  Copy message to capture socket if any
-                if (capture_) {
-                    msg_t ctrl;
-                    rc = ctrl.init ();
-                    if (unlikely (rc < 0))
-                        return -1;
-                    rc = ctrl.copy (msg);
-                    if (unlikely (rc < 0))
-                        return -1;
-                    rc = capture_->send (&ctrl, more? ZMQ_SNDMORE: 0);
-                    if (unlikely (rc < 0))
-                        return -1;
-                }
-                rc = backend_->send (&msg, more? ZMQ_SNDMORE: 0);
-                if (unlikely (rc < 0))
-                    return -1;
-                if (more == 0)
-                    break;
-            }
+        //  Process a command.
+        if (items [2].revents & ZMQ_POLLIN) {
+            rc = process_command (control_, &paused, requests_, replies_);
+            if (unlikely (rc < 0))
+                return -1;
+            if (rc == 1)
+                return 0;
         }
-        //  Process a reply
-        if (items [1].revents & ZMQ_POLLIN) {
-            while (true) {
-                rc = backend_->recv (&msg, 0);
-                if (unlikely (rc < 0))
-                    return -1;
-
-                moresz = sizeof more;
-                rc = backend_->getsockopt (ZMQ_RCVMORE, &more, &moresz);
-                if (unlikely (rc < 0))
-                    return -1;
-
-                //  Copy message to capture socket if any
-                if (capture_) {
-                    msg_t ctrl;
-                    rc = ctrl.init ();
-                    if (unlikely (rc < 0))
-                        return -1;
-                    rc = ctrl.copy (msg);
-                    if (unlikely (rc < 0))
-                        return -1;
-                    rc = capture_->send (&ctrl, more? ZMQ_SNDMORE: 0);
-                    if (unlikely (rc < 0))
-                        return -1;
-                }
-                rc = frontend_->send (&msg, more? ZMQ_SNDMORE: 0);
-                if (unlikely (rc < 0))
-                    return -1;
-                if (more == 0)
-                    break;
-            }
+
+        //  Process requests.
+        if (items [0].revents & ZMQ_POLLIN ||
+              items [1].revents & ZMQ_POLLOUT) {
+            rc = forward (requests_, capture_);
+            if (unlikely (rc < 0))
+                return -1;
         }
 
+        //  Process replies.
+        if (items [1].revents & ZMQ_POLLIN ||
+              items [0].revents & ZMQ_POLLOUT) {
+            rc = forward (replies_, capture_);
+            if (unlikely (rc < 0))
+                return -1;
+        }
     }
-    return 0;
 }
+
+int zmq::proxy (
+    class socket_base_t *frontend_,
+    class socket_base_t *backend_,
+    class socket_base_t *capture_,
+    class socket_base_t *control_)
+{
+    direction_t requests;
+    int rc = init_direction (&requests, frontend_, backend_);
+    if (rc != 0)
+        return -1;
+
+    direction_t replies;
+    rc = init_direction (&replies, backend_, frontend_);
+    if (rc != 0) {
+        requests.msg.close ();
+        return -1;
+    }
+
+    //  The loop exits only on error or when told to terminate. Closing the
+    //  messages must not overwrite the error code.
+    rc = proxy_loop (&requests, &replies, capture_, control_);
+    int err = errno;
+    requests.msg.close ();
+    replies.msg.close ();
+    errno = err;
+    return rc;
+}
+
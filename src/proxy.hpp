@@ -23,9 +23,13 @@
 
 namespace zmq
 {
+    //  Passes messages between the frontend and the backend till the
+    //  context is terminated or a TERMINATE command arrives on the control
+    //  socket. Capture and control sockets are optional.
     int proxy (
         class socket_base_t *frontend_,
         class socket_base_t *backend_,
+        class socket_base_t *capture_,
         class socket_base_t *control_);
 }
 
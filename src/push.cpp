@@ -63,6 +63,23 @@ bool zmq::push_t::xhas_out ()
     return lb.has_out ();
 }
 
+void zmq::push_t::xbegin_batch ()
+{
+    lb.begin_batch ();
+}
+
+void zmq::push_t::xend_batch ()
+{
+    lb.end_batch ();
+}
+
+void zmq::push_t::xget_drops (uint64_t *hwm_drops_, uint64_t *unroutable_drops_)
+{
+    //  Load balancer blocks rather than drops when the pipes are full.
+    *hwm_drops_ = 0;
+    *unroutable_drops_ = lb.get_drops ();
+}
+
 zmq::push_session_t::push_session_t (io_thread_t *io_thread_, bool connect_,
       socket_base_t *socket_, const options_t &options_,
       const address_t *addr_) :
@@ -47,9 +47,12 @@ namespace zmq
         //  Overloads of functions from socket_base_t.
         void xattach_pipe (zmq::pipe_t *pipe_, bool icanhasall_);
         int xsend (zmq::msg_t *msg_, int flags_);
+        void xbegin_batch ();
+        void xend_batch ();
         bool xhas_out ();
         void xwrite_activated (zmq::pipe_t *pipe_);
         void xterminated (zmq::pipe_t *pipe_);
+        void xget_drops (uint64_t *hwm_drops_, uint64_t *unroutable_drops_);
 
     private:
 
@@ -19,12 +19,14 @@
 */
 
 #include <stdlib.h>
+#include <errno.h>
 
 #include "platform.hpp"
 #if defined ZMQ_HAVE_WINDOWS
 #include "windows.hpp"
 #else
 #include <unistd.h>
+#include <fcntl.h>
 #endif
 
 #include "random.hpp"
@@ -50,3 +52,27 @@ uint32_t zmq::generate_random ()
     return high | low;
 }
 
+void zmq::generate_random_bytes (void *buffer_, size_t size_)
+{
+    unsigned char *buffer = (unsigned char*) buffer_;
+    size_t filled = 0;
+
+#if !defined ZMQ_HAVE_WINDOWS
+    int fd = open ("/dev/urandom", O_RDONLY);
+    if (fd != -1) {
+        while (filled < size_) {
+            ssize_t nbytes = read (fd, buffer + filled, size_ - filled);
+            if (nbytes == -1 && errno == EINTR)
+                continue;
+            if (nbytes <= 0)
+                break;
+            filled += nbytes;
+        }
+        close (fd);
+    }
+#endif
+
+    //  No entropy source available.
+    for (; filled < size_; filled++)
+        buffer [filled] = (unsigned char) generate_random ();
+}
@@ -21,6 +21,8 @@
 #ifndef __ZMQ_RANDOM_HPP_INCLUDED__
 #define __ZMQ_RANDOM_HPP_INCLUDED__
 
+#include <stddef.h>
+
 #include "stdint.hpp"
 
 namespace zmq
@@ -32,6 +34,12 @@ namespace zmq
     //  Generates random value.
     uint32_t generate_random ();
 
+    //  Fills the buffer with random bytes taken from the operating system's
+    //  entropy source where there is one, so that they can't be guessed
+    //  from the seed of generate_random. Falls back to generate_random
+    //  otherwise.
+    void generate_random_bytes (void *buffer_, size_t size_);
+
 }
 
 #endif
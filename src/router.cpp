@@ -35,7 +35,9 @@ zmq::router_t::router_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     current_out (NULL),
     more_out (false),
     next_peer_id (generate_random ()),
-    mandatory(false)
+    mandatory(false),
+    hwm_drops (0),
+    unroutable_drops (0)
 {
     options.type = ZMQ_ROUTER;
 
@@ -53,7 +55,7 @@ zmq::router_t::router_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
 
 zmq::router_t::~router_t ()
 {
-    zmq_assert (anonymous_pipes.empty ());;
+    zmq_assert (anonymous_pipes.empty ());
     zmq_assert (outpipes.empty ());
     prefetched_id.close ();
     prefetched_msg.close ();
@@ -70,7 +72,7 @@ void zmq::router_t::xattach_pipe (pipe_t *pipe_, bool icanhasall_)
     if (identity_ok)
         fq.attach (pipe_);
     else
-        anonymous_pipes.insert (pipe_);
+        anonymous_pipes.push_back (pipe_);
 }
 
 int zmq::router_t::xsetsockopt (int option_, const void *optval_,
@@ -90,13 +92,10 @@ int zmq::router_t::xsetsockopt (int option_, const void *optval_,
 
 void zmq::router_t::xterminated (pipe_t *pipe_)
 {
-    std::set <pipe_t*>::iterator it = anonymous_pipes.find (pipe_);
-    if (it != anonymous_pipes.end ())
-        anonymous_pipes.erase (it);
+    if (is_anonymous (pipe_))
+        anonymous_pipes.erase (pipe_);
     else {
-        outpipes_t::iterator it = outpipes.find (pipe_->get_identity ());
-        zmq_assert (it != outpipes.end ());
-        outpipes.erase (it);
+        outpipes.erase (pipe_);
         fq.terminated (pipe_);
         if (pipe_ == current_out)
             current_out = NULL;
@@ -105,13 +104,12 @@ void zmq::router_t::xterminated (pipe_t *pipe_)
 
 void zmq::router_t::xread_activated (pipe_t *pipe_)
 {
-    std::set <pipe_t*>::iterator it = anonymous_pipes.find (pipe_);
-    if (it == anonymous_pipes.end ())
+    if (!is_anonymous (pipe_))
         fq.activated (pipe_);
     else {
         bool identity_ok = identify_peer (pipe_);
         if (identity_ok) {
-            anonymous_pipes.erase (it);
+            anonymous_pipes.erase (pipe_);
             fq.attach (pipe_);
         }
     }
@@ -119,14 +117,10 @@ void zmq::router_t::xread_activated (pipe_t *pipe_)
 
 void zmq::router_t::xwrite_activated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zmq_assert (it != outpipes.end ());
-    zmq_assert (!it->second.active);
-    it->second.active = true;
+    identity_table_t::entry_t *outpipe = outpipes.find (pipe_);
+    zmq_assert (outpipe);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
 }
 
 int zmq::router_t::xsend (msg_t *msg_, int flags_)
@@ -149,14 +143,17 @@ int zmq::router_t::xsend (msg_t *msg_, int flags_)
             //  Find the pipe associated with the identity stored in the prefix.
             //  If there's no such pipe just silently ignore the message, unless
             //  report_unreachable is set.
-            blob_t identity ((unsigned char*) msg_->data (), msg_->size ());
-            outpipes_t::iterator it = outpipes.find (identity);
+            const unsigned char *identity = (unsigned char*) msg_->data ();
+            const size_t size = msg_->size ();
+            identity_table_t::entry_t *outpipe =
+                outpipes.find (identity, size, outpipes.hash (identity, size));
 
-            if (it != outpipes.end ()) {
-                current_out = it->second.pipe;
+            if (outpipe) {
+                current_out = outpipe->pipe;
                 if (!current_out->check_write ()) {
-                    it->second.active = false;
+                    outpipe->active = false;
                     current_out = NULL;
+                    hwm_drops++;
                 }
             } 
             else 
@@ -165,6 +162,8 @@ int zmq::router_t::xsend (msg_t *msg_, int flags_)
                 errno = EHOSTUNREACH;
                 return -1;
             }
+            else
+                unroutable_drops++;
         }
 
         int rc = msg_->close ();
@@ -180,8 +179,10 @@ int zmq::router_t::xsend (msg_t *msg_, int flags_)
     //  Push the message into the pipe. If there's no out pipe, just drop it.
     if (current_out) {
         bool ok = current_out->write (msg_);
-        if (unlikely (!ok))
+        if (unlikely (!ok)) {
             current_out = NULL;
+            hwm_drops++;
+        }
         else if (!more_out) {
             current_out->flush ();
             current_out = NULL;
@@ -245,7 +246,7 @@ int zmq::router_t::xrecv (msg_t *msg_, int flags_)
         errno_assert (rc == 0);
         prefetched = true;
 
-        blob_t identity = pipe->get_identity ();
+        const blob_t &identity = pipe->get_identity ();
         rc = msg_->init_size (identity.size ());
         errno_assert (rc == 0);
         memcpy (msg_->data (), identity.data (), identity.size ());
@@ -294,7 +295,7 @@ bool zmq::router_t::xhas_in ()
 
     zmq_assert (pipe != NULL);
 
-    blob_t identity = pipe->get_identity ();
+    const blob_t &identity = pipe->get_identity ();
     rc = prefetched_id.init_size (identity.size ());
     errno_assert (rc == 0);
     memcpy (prefetched_id.data (), identity.data (), identity.size ());
@@ -314,6 +315,13 @@ bool zmq::router_t::xhas_out ()
     return true;
 }
 
+void zmq::router_t::xget_drops (uint64_t *hwm_drops_,
+    uint64_t *unroutable_drops_)
+{
+    *hwm_drops_ = hwm_drops;
+    *unroutable_drops_ = unroutable_drops;
+}
+
 bool zmq::router_t::identify_peer (pipe_t *pipe_)
 {
     msg_t msg;
@@ -334,23 +342,30 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_)
     }
     else {
         identity = blob_t ((unsigned char*) msg.data (), msg.size ());
-        outpipes_t::iterator it = outpipes.find (identity);
         msg.close ();
 
         //  Ignore peers with duplicate ID.
-        if (it != outpipes.end ())
+        if (outpipes.find (identity.data (), identity.size (),
+              outpipes.hash (identity.data (), identity.size ())))
             return false;
     }
 
     pipe_->set_identity (identity);
     //  Add the record into output pipes lookup table
-    outpipe_t outpipe = {pipe_, true};
-    ok = outpipes.insert (outpipes_t::value_type (identity, outpipe)).second;
-    zmq_assert (ok);
+    outpipes.insert (pipe_);
 
     return true;
 }
 
+bool zmq::router_t::is_anonymous (pipe_t *pipe_)
+{
+    //  The array index of a pipe that was never stored in the array, or was
+    //  already removed from it, is either out of range or points to some
+    //  other pipe.
+    const anonymous_pipes_t::size_type index = anonymous_pipes.index (pipe_);
+    return index < anonymous_pipes.size () && anonymous_pipes [index] == pipe_;
+}
+
 zmq::router_session_t::router_session_t (io_thread_t *io_thread_, bool connect_,
       socket_base_t *socket_, const options_t &options_,
       const address_t *addr_) :
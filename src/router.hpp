@@ -23,14 +23,14 @@
 #ifndef __ZMQ_ROUTER_HPP_INCLUDED__
 #define __ZMQ_ROUTER_HPP_INCLUDED__
 
-#include <map>
-
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "stdint.hpp"
 #include "blob.hpp"
 #include "msg.hpp"
 #include "fq.hpp"
+#include "array.hpp"
+#include "identity_table.hpp"
 
 namespace zmq
 {
@@ -38,7 +38,6 @@ namespace zmq
     class ctx_t;
     class pipe_t;
 
-    //  TODO: This class uses O(n) scheduling. Rewrite it to use O(1) algorithm.
     class router_t :
         public socket_base_t
     {
@@ -57,6 +56,7 @@ namespace zmq
         void xread_activated (zmq::pipe_t *pipe_);
         void xwrite_activated (zmq::pipe_t *pipe_);
         void xterminated (zmq::pipe_t *pipe_);
+        void xget_drops (uint64_t *hwm_drops_, uint64_t *unroutable_drops_);
 
     protected:
 
@@ -68,6 +68,9 @@ namespace zmq
         //  Receive peer id and update lookup map
         bool identify_peer (pipe_t *pipe_);
 
+        //  Returns true iff the pipe has not been identified yet.
+        bool is_anonymous (pipe_t *pipe_);
+
         //  Fair queueing object for inbound pipes.
         fq_t fq;
 
@@ -87,18 +90,16 @@ namespace zmq
         //  If true, more incoming message parts are expected.
         bool more_in;
 
-        struct outpipe_t
-        {
-            zmq::pipe_t *pipe;
-            bool active;
-        };
+        //  We keep an array of pipes that have not been identified yet.
+        //  Unidentified pipes are never part of the fair-queue or of any
+        //  outbound distribution, so they can use the array slot otherwise
+        //  taken by lb_t and dist_t.
+        typedef array_t <pipe_t, 2> anonymous_pipes_t;
+        anonymous_pipes_t anonymous_pipes;
 
-        //  We keep a set of pipes that have not been identified yet.
-        std::set <pipe_t*> anonymous_pipes;
-
-        //  Outbound pipes indexed by the peer IDs.
-        typedef std::map <blob_t, outpipe_t> outpipes_t;
-        outpipes_t outpipes;
+        //  Outbound pipes indexed by the peer IDs. The 'active' flag of an
+        //  entry is reset when the pipe gets full.
+        identity_table_t outpipes;
 
         //  The pipe we are currently writing to.
         zmq::pipe_t *current_out;
@@ -114,6 +115,11 @@ namespace zmq
         // the message targeting an unknown peer.
         bool mandatory;
 
+        //  Number of messages dropped because the peer's pipe was full and
+        //  because the peer was unknown, respectively.
+        uint64_t hwm_drops;
+        uint64_t unroutable_drops;
+
         router_t (const router_t&);
         const router_t &operator = (const router_t&);
     };
@@ -153,6 +153,9 @@ void zmq::select_t::loop ()
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
 
+        //  Apply the message releases deferred while handling the events.
+        flush_releases ();
+
         //  Intialise the pollsets.
         memcpy (&readfds, &source_set_in, sizeof source_set_in);
         memcpy (&writefds, &source_set_out, sizeof source_set_out);
@@ -131,6 +131,10 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_, uint32_t tid_, int sid_) :
     last_tsc (0),
     ticks (0),
     rcvmore (false),
+    msgs_in (0),
+    bytes_in (0),
+    msgs_out (0),
+    bytes_out (0),
     monitor_socket (NULL),
     monitor_events (0)
 {
@@ -227,6 +231,8 @@ void zmq::socket_base_t::attach_pipe (pipe_t *pipe_, bool icanhasall_)
     
     //  Let the derived socket type know about new pipe.
     xattach_pipe (pipe_, icanhasall_);
+    if (unlikely (!poller_items.empty ()))
+        touch_pollers ();
 
     //  If the socket is already being closed, ask any new pipes to terminate
     //  straight away.
@@ -300,6 +306,29 @@ int zmq::socket_base_t::getsockopt (int option_, void *optval_,
         return 0;
     }
 
+    if (option_ == ZMQ_STATISTICS) {
+        if (*optvallen_ < sizeof (uint64_t)) {
+            errno = EINVAL;
+            return -1;
+        }
+        uint64_t stats [ZMQ_STAT_COUNT];
+        stats [ZMQ_STAT_MSGS_IN] = msgs_in;
+        stats [ZMQ_STAT_BYTES_IN] = bytes_in;
+        stats [ZMQ_STAT_MSGS_OUT] = msgs_out;
+        stats [ZMQ_STAT_BYTES_OUT] = bytes_out;
+        xget_drops (&stats [ZMQ_STAT_HWM_DROPS],
+            &stats [ZMQ_STAT_UNROUTABLE_DROPS]);
+        stats [ZMQ_STAT_RECONNECTS] = reconnects.get ();
+
+        //  Older applications may ask for fewer counters than we have.
+        size_t count = *optvallen_ / sizeof (uint64_t);
+        if (count > ZMQ_STAT_COUNT)
+            count = ZMQ_STAT_COUNT;
+        memcpy (optval_, stats, count * sizeof (uint64_t));
+        *optvallen_ = count * sizeof (uint64_t);
+        return 0;
+    }
+
     return options.getsockopt (option_, optval_, optvallen_);
 }
 
@@ -640,6 +669,10 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
         return -1;
     }
 
+    //  Sending may change the socket's state, let the pollers know.
+    if (unlikely (!poller_items.empty ()))
+        touch_pollers ();
+
     //  Process pending commands, if any.
     int rc = process_commands (0, true);
     if (unlikely (rc != 0))
@@ -652,10 +685,15 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
     if (flags_ & ZMQ_SNDMORE)
         msg_->set_flags (msg_t::more);
 
+    //  The message is emptied by xsend, so remember its size beforehand.
+    size_t size = msg_->size ();
+
     //  Try to send the message.
     rc = xsend (msg_, flags_);
-    if (rc == 0)
+    if (rc == 0) {
+        account_out (size, flags_);
         return 0;
+    }
     if (unlikely (errno != EAGAIN))
         return -1;
 
@@ -688,9 +726,85 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
             }
         }
     }
+    account_out (size, flags_);
     return 0;
 }
 
+int zmq::socket_base_t::send_batch (msg_t *msgs_, int count_, int flags_)
+{
+    //  Check whether the library haven't been shut down yet.
+    if (unlikely (ctx_terminated)) {
+        errno = ETERM;
+        return -1;
+    }
+
+    //  Check whether messages passed to the function are valid.
+    for (int i = 0; i != count_; i++) {
+        if (unlikely (!msgs_ [i].check ())) {
+            errno = EFAULT;
+            return -1;
+        }
+    }
+
+    //  Sending may change the socket's state, let the pollers know.
+    if (unlikely (!poller_items.empty ()))
+        touch_pollers ();
+
+    //  Process pending commands, if any.
+    int rc = process_commands (0, true);
+    if (unlikely (rc != 0))
+        return -1;
+
+    //  Compute the time when the timeout should occur.
+    //  If the timeout is infite, don't care.
+    int timeout = options.sndtimeo;
+    uint64_t end = timeout < 0 ? 0 : (clock.now_ms () + timeout);
+
+    while (true) {
+
+        //  Write as many messages as possible without blocking. The pipes
+        //  are flushed once, at the end of the batch.
+        int nmsgs = 0;
+        int err = 0;
+        xbegin_batch ();
+        while (nmsgs != count_) {
+            msgs_ [nmsgs].reset_flags (msg_t::more);
+            size_t size = msgs_ [nmsgs].size ();
+            rc = xsend (&msgs_ [nmsgs], flags_ | ZMQ_DONTWAIT);
+            if (rc != 0) {
+                err = errno;
+                break;
+            }
+            account_out (size, flags_);
+            nmsgs++;
+        }
+        xend_batch ();
+        if (nmsgs > 0)
+            return nmsgs;
+        errno = err;
+        if (unlikely (errno != EAGAIN))
+            return -1;
+
+        //  In case of non-blocking send we'll simply propagate
+        //  the error - including EAGAIN - up the stack.
+        if (flags_ & ZMQ_DONTWAIT || options.sndtimeo == 0)
+            return -1;
+
+        //  No message could be sent. Wait for the next command, process it
+        //  and try again. If timeout is reached in the meantime, return
+        //  EAGAIN.
+        if (unlikely (process_commands (timeout, false) != 0))
+            return -1;
+        if (timeout > 0) {
+            timeout = (int) (end - clock.now_ms ());
+            if (timeout <= 0) {
+                errno = EAGAIN;
+                return -1;
+            }
+        }
+    }
+}
+
 int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
 {
     //  Check whether the library haven't been shut down yet.
@@ -705,6 +819,10 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
         return -1;
     }
 
+    //  Receiving may change the socket's state, let the pollers know.
+    if (unlikely (!poller_items.empty ()))
+        touch_pollers ();
+
     //  Once every inbound_poll_rate messages check for signals and process
     //  incoming commands. This happens only if we are not polling altogether
     //  because there are messages available all the time. If poll occurs,
@@ -778,10 +896,58 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
     return 0;
 }
 
+int zmq::socket_base_t::recv_batch (msg_t *msgs_, int count_, int flags_)
+{
+    int err = errno;
+
+    //  Check whether messages passed to the function are valid.
+    for (int i = 0; i != count_; i++) {
+        if (unlikely (!msgs_ [i].check ())) {
+            errno = EFAULT;
+            return -1;
+        }
+    }
+
+    //  The first message part is received in the standard way, i.e. waiting
+    //  for it if needed and processing commands.
+    int rc = recv (&msgs_ [0], flags_);
+    if (unlikely (rc != 0))
+        return -1;
+
+    //  Subsequent parts are fetched only if they are immediately available.
+    //  Commands are not processed in the meantime, thus the check for new
+    //  commands is done once per batch rather than once per message. The
+    //  batch is counted in parts, so it may end in the middle of a message;
+    //  its remaining parts are left for the next call. Running out of parts
+    //  is not an error, so errno is left as it was on entry.
+    int nmsgs = 1;
+    while (nmsgs != count_) {
+        rc = xrecv (&msgs_ [nmsgs], flags_ | ZMQ_DONTWAIT);
+        if (rc != 0) {
+            errno = err;
+            break;
+        }
+        extract_flags (&msgs_ [nmsgs]);
+        nmsgs++;
+    }
+
+    //  Make sure the commands get processed on the next recv if the batch
+    //  was large enough to warrant it.
+    ticks += nmsgs - 1;
+    if (ticks >= inbound_poll_rate)
+        ticks = inbound_poll_rate - 1;
+
+    return nmsgs;
+}
+
 int zmq::socket_base_t::close ()
 {
     //  Mark the socket as dead
     tag = 0xdeadbeef;
+
+    //  Remove the socket from the pollers it's still registered with.
+    while (!poller_items.empty ())
+        poller_items.back ()->poller->remove (this);
     
     //  Transfer the ownership of the socket from this application thread
     //  to the reaper thread which will take care of the rest of shutdown
@@ -801,6 +967,26 @@ bool zmq::socket_base_t::has_out ()
     return xhas_out ();
 }
 
+void zmq::socket_base_t::add_poller_item (socket_poller_t::item_t *item_)
+{
+    poller_items.push_back (item_);
+}
+
+void zmq::socket_base_t::remove_poller_item (socket_poller_t::item_t *item_)
+{
+    poller_items_t::iterator it = std::find (poller_items.begin (),
+        poller_items.end (), item_);
+    zmq_assert (it != poller_items.end ());
+    poller_items.erase (it);
+}
+
+void zmq::socket_base_t::touch_pollers ()
+{
+    for (poller_items_t::iterator it = poller_items.begin ();
+          it != poller_items.end (); ++it)
+        (*it)->poller->touch (*it);
+}
+
 void zmq::socket_base_t::start_reaping (poller_t *poller_)
 {
     //  Plug the socket to the reaper thread.
@@ -852,6 +1038,8 @@ int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
     }
 
     //  Process all available commands.
+    if (rc == 0 && unlikely (!poller_items.empty ()))
+        touch_pollers ();
     while (rc == 0) {
         cmd.destination->process_command (cmd);
         rc = mailbox.recv (&cmd, 0);
@@ -923,6 +1111,14 @@ int zmq::socket_base_t::xsend (msg_t *, int)
     return -1;
 }
 
+void zmq::socket_base_t::xbegin_batch ()
+{
+}
+
+void zmq::socket_base_t::xend_batch ()
+{
+}
+
 bool zmq::socket_base_t::xhas_in ()
 {
     return false;
@@ -948,6 +1144,13 @@ void zmq::socket_base_t::xhiccuped (pipe_t *)
     zmq_assert (false);
 }
 
+void zmq::socket_base_t::xget_drops (uint64_t *hwm_drops_,
+    uint64_t *unroutable_drops_)
+{
+    *hwm_drops_ = 0;
+    *unroutable_drops_ = 0;
+}
+
 void zmq::socket_base_t::in_event ()
 {
     //  This function is invoked only once the socket is running in the context
@@ -1034,6 +1237,18 @@ void zmq::socket_base_t::extract_flags (msg_t *msg_)
   
     //  Remove MORE flag.
     rcvmore = msg_->flags () & msg_t::more ? true : false;
+
+    //  Account for the received message part.
+    bytes_in += msg_->size ();
+    if (!rcvmore)
+        msgs_in++;
+}
+
+void zmq::socket_base_t::account_out (size_t size_, int flags_)
+{
+    bytes_out += size_;
+    if (!(flags_ & ZMQ_SNDMORE))
+        msgs_out++;
 }
 
 int zmq::socket_base_t::monitor (const char *addr_, int events_)
@@ -1112,6 +1327,7 @@ void zmq::socket_base_t::event_connect_delayed (std::string &addr_, int err_)
 
 void zmq::socket_base_t::event_connect_retried (std::string &addr_, int interval_)
 {
+    reconnects.add (1);
     if (monitor_events & ZMQ_EVENT_CONNECT_RETRIED) {
         zmq_event_t event;
         event.event = ZMQ_EVENT_CONNECT_RETRIED;
@@ -37,6 +37,7 @@
 #include "stdint.hpp"
 #include "clock.hpp"
 #include "pipe.hpp"
+#include "socket_poller.hpp"
 
 extern "C"
 {
@@ -81,7 +82,9 @@ namespace zmq
         int connect (const char *addr_);
         int term_endpoint (const char *addr_);
         int send (zmq::msg_t *msg_, int flags_);
+        int send_batch (zmq::msg_t *msgs_, int count_, int flags_);
         int recv (zmq::msg_t *msg_, int flags_);
+        int recv_batch (zmq::msg_t *msgs_, int count_, int flags_);
         int close ();
 
         //  These functions are used by the polling mechanism to determine
@@ -89,6 +92,12 @@ namespace zmq
         bool has_in ();
         bool has_out ();
 
+        //  Used by zmq_poller_* to register the poller items for this socket.
+        //  The pollers are told whenever the socket is used, as its state can
+        //  change then without its file descriptor being signaled.
+        void add_poller_item (socket_poller_t::item_t *item_);
+        void remove_poller_item (socket_poller_t::item_t *item_);
+
         //  Using this function reaper thread ask the socket to regiter with
         //  its poller.
         void start_reaping (poller_t *poller_);
@@ -140,6 +149,12 @@ namespace zmq
         virtual bool xhas_out ();
         virtual int xsend (zmq::msg_t *msg_, int flags_);
 
+        //  Called around a sequence of xsend calls issued by send_batch.
+        //  Socket types that are able to flush their pipes only once per
+        //  batch should overload these. By default they do nothing.
+        virtual void xbegin_batch ();
+        virtual void xend_batch ();
+
         //  The default implementation assumes that recv in not supported.
         virtual bool xhas_in ();
         virtual int xrecv (zmq::msg_t *msg_, int flags_);
@@ -150,6 +165,12 @@ namespace zmq
         virtual void xhiccuped (pipe_t *pipe_);
         virtual void xterminated (pipe_t *pipe_) = 0;
 
+        //  Retrieves the number of messages the socket type has dropped
+        //  because of the high watermark and because there was no peer to
+        //  route them to. The default implementation reports no drops.
+        virtual void xget_drops (uint64_t *hwm_drops_,
+            uint64_t *unroutable_drops_);
+
         //  Delay actual destruction of the socket.
         void process_destroy ();
 
@@ -179,9 +200,14 @@ namespace zmq
         void check_destroy ();
 
         //  Moves the flags from the message to local variables,
-        //  to be later retrieved by getsockopt.
+        //  to be later retrieved by getsockopt. Updates the inbound
+        //  traffic counters.
         void extract_flags (msg_t *msg_);
 
+        //  Updates the outbound traffic counters with a message part
+        //  that was sent with flags_.
+        void account_out (size_t size_, int flags_);
+
         //  Used to check whether the object is a socket.
         uint32_t tag;
 
@@ -235,6 +261,16 @@ namespace zmq
         //  True if the last message received had MORE flag set.
         bool rcvmore;
 
+        //  Traffic counters reported by ZMQ_STATISTICS. Messages are
+        //  counted when their last part is sent or received.
+        uint64_t msgs_in;
+        uint64_t bytes_in;
+        uint64_t msgs_out;
+        uint64_t bytes_out;
+
+        //  Number of reconnection attempts. Updated from the I/O threads.
+        atomic_counter_t reconnects;
+
         //  Improves efficiency of time measurement.
         clock_t clock;
 
@@ -244,6 +280,13 @@ namespace zmq
         // Bitmask of events being monitored
         int monitor_events;
 
+        //  Items of the zmq_poller_* pollers the socket is registered with.
+        typedef std::vector <socket_poller_t::item_t*> poller_items_t;
+        poller_items_t poller_items;
+
+        //  Tells the pollers that the socket's state may have changed.
+        void touch_pollers ();
+
         socket_base_t (const socket_base_t&);
         const socket_base_t &operator = (const socket_base_t&);
         mutex_t sync;
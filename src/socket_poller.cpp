@@ -0,0 +1,394 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <new>
+#include <algorithm>
+
+#include "socket_poller.hpp"
+#include "socket_base.hpp"
+#include "clock.hpp"
+#include "err.hpp"
+
+#if defined ZMQ_USE_EPOLL
+#include <unistd.h>
+#endif
+
+zmq::socket_poller_t::socket_poller_t () :
+#if !defined ZMQ_USE_EPOLL
+    rebuild (false),
+#endif
+    tag (0xcafebabe)
+{
+#if defined ZMQ_USE_EPOLL
+    epoll_fd = epoll_create (1);
+    errno_assert (epoll_fd != -1);
+
+    //  epoll_wait needs room for at least one event.
+    ready.resize (1);
+#endif
+}
+
+zmq::socket_poller_t::~socket_poller_t ()
+{
+    //  Mark the poller as dead.
+    tag = 0xdeadbeef;
+
+    for (items_t::iterator it = items.begin (); it != items.end (); ++it) {
+        if ((*it)->socket)
+            (*it)->socket->remove_poller_item (*it);
+        delete *it;
+    }
+#if defined ZMQ_USE_EPOLL
+    close (epoll_fd);
+#endif
+}
+
+bool zmq::socket_poller_t::check_tag ()
+{
+    return tag == 0xcafebabe;
+}
+
+int zmq::socket_poller_t::add (socket_base_t *socket_, void *user_data_,
+    short events_)
+{
+    fd_t fd;
+    size_t fd_size = sizeof (fd);
+    int rc = socket_->getsockopt (ZMQ_FD, &fd, &fd_size);
+    if (rc != 0)
+        return -1;
+    return add_item (socket_, fd, user_data_, events_);
+}
+
+int zmq::socket_poller_t::modify (socket_base_t *socket_, short events_)
+{
+    return modify_item (socket_, retired_fd, events_);
+}
+
+int zmq::socket_poller_t::remove (socket_base_t *socket_)
+{
+    return remove_item (socket_, retired_fd);
+}
+
+int zmq::socket_poller_t::add_fd (fd_t fd_, void *user_data_,
+    short events_)
+{
+    return add_item (NULL, fd_, user_data_, events_);
+}
+
+int zmq::socket_poller_t::modify_fd (fd_t fd_, short events_)
+{
+    return modify_item (NULL, fd_, events_);
+}
+
+int zmq::socket_poller_t::remove_fd (fd_t fd_)
+{
+    return remove_item (NULL, fd_);
+}
+
+zmq::socket_poller_t::items_t::iterator zmq::socket_poller_t::find (
+    socket_base_t *socket_, fd_t fd_)
+{
+    for (items_t::iterator it = items.begin (); it != items.end (); ++it)
+        if (socket_ ? (*it)->socket == socket_ :
+              !(*it)->socket && (*it)->fd == fd_)
+            return it;
+    return items.end ();
+}
+
+int zmq::socket_poller_t::add_item (socket_base_t *socket_, fd_t fd_,
+    void *user_data_, short events_)
+{
+    if (find (socket_, fd_) != items.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    item_t *item = new (std::nothrow) item_t;
+    alloc_assert (item);
+    item->poller = this;
+    item->socket = socket_;
+    item->fd = fd_;
+    item->user_data = user_data_;
+    item->events = events_;
+    item->dirty = false;
+    items.push_back (item);
+    if (socket_)
+        socket_->add_poller_item (item);
+
+#if defined ZMQ_USE_EPOLL
+    set_events (item, EPOLL_CTL_ADD);
+    if (ready.size () < items.size ())
+        ready.resize (items.size ());
+
+    //  The socket may be ready already.
+    if (socket_)
+        touch (item);
+#else
+    rebuild = true;
+#endif
+    return 0;
+}
+
+int zmq::socket_poller_t::modify_item (socket_base_t *socket_, fd_t fd_,
+    short events_)
+{
+    items_t::iterator it = find (socket_, fd_);
+    if (it == items.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+    (*it)->events = events_;
+
+#if defined ZMQ_USE_EPOLL
+    set_events (*it, EPOLL_CTL_MOD);
+    if (socket_)
+        touch (*it);
+#else
+    rebuild = true;
+#endif
+    return 0;
+}
+
+int zmq::socket_poller_t::remove_item (socket_base_t *socket_, fd_t fd_)
+{
+    items_t::iterator it = find (socket_, fd_);
+    if (it == items.end ()) {
+        errno = EINVAL;
+        return -1;
+    }
+
+#if defined ZMQ_USE_EPOLL
+    int rc = epoll_ctl (epoll_fd, EPOLL_CTL_DEL, (*it)->fd, NULL);
+    errno_assert (rc != -1);
+    if ((*it)->dirty) {
+        for (items_t::iterator d = dirty.begin (); d != dirty.end (); ++d)
+            if (*d == *it) {
+                *d = dirty.back ();
+                dirty.pop_back ();
+                break;
+            }
+    }
+#else
+    rebuild = true;
+#endif
+    if (socket_)
+        socket_->remove_poller_item (*it);
+
+    //  The order of the items doesn't matter.
+    delete *it;
+    *it = items.back ();
+    items.pop_back ();
+    return 0;
+}
+
+void zmq::socket_poller_t::touch (item_t *item_)
+{
+#if defined ZMQ_USE_EPOLL
+    if (!item_->dirty) {
+        item_->dirty = true;
+        dirty.push_back (item_);
+    }
+#else
+    //  zmq_poll checks all the sockets anyway.
+    (void) item_;
+#endif
+}
+
+#if defined ZMQ_USE_EPOLL
+
+void zmq::socket_poller_t::set_events (item_t *item_, int op_)
+{
+    epoll_event ev;
+    ev.data.ptr = item_;
+    ev.events = 0;
+
+    //  A socket's file descriptor signals that there are commands to
+    //  process. It doesn't tell anything about the socket's state.
+    if (item_->socket) {
+        if (item_->events & (ZMQ_POLLIN | ZMQ_POLLOUT))
+            ev.events = EPOLLIN;
+    }
+    else {
+        if (item_->events & ZMQ_POLLIN)
+            ev.events |= EPOLLIN;
+        if (item_->events & ZMQ_POLLOUT)
+            ev.events |= EPOLLOUT;
+    }
+    int rc = epoll_ctl (epoll_fd, op_, item_->fd, &ev);
+    errno_assert (rc != -1);
+}
+
+int zmq::socket_poller_t::wait (zmq_poller_event_t *events_, int n_events_,
+    long timeout_)
+{
+    if (items.empty () && timeout_ < 0) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    uint64_t end = timeout_ > 0 ? clock_t::now_us () / 1000 + timeout_ : 0;
+    bool first_pass = true;
+    while (true) {
+
+        //  On the first pass, don't wait. The sockets may be ready even
+        //  though their file descriptors are not signaled, eg. when there
+        //  are messages left unread.
+        int timeout = 0;
+        if (!first_pass) {
+            if (timeout_ < 0)
+                timeout = -1;
+            else {
+                uint64_t now = clock_t::now_us () / 1000;
+                if (now >= end) {
+                    errno = EAGAIN;
+                    return -1;
+                }
+                timeout = (int) (end - now);
+            }
+        }
+        int rc = epoll_wait (epoll_fd, &ready [0], (int) ready.size (),
+            timeout);
+        if (rc == -1 && errno == EINTR)
+            return -1;
+        errno_assert (rc != -1);
+
+        //  Let the signaled sockets process their commands and check them
+        //  below. Raw file descriptors can be reported straight away.
+        int found = 0;
+        for (int i = 0; i != rc; i++) {
+            item_t *item = (item_t*) ready [i].data.ptr;
+            if (item->socket) {
+                int events;
+                size_t events_size = sizeof (events);
+                if (item->socket->getsockopt (ZMQ_EVENTS, &events,
+                      &events_size) == -1)
+                    return -1;
+                touch (item);
+                continue;
+            }
+            if (found == n_events_)
+                continue;
+            short revents = 0;
+            if (ready [i].events & EPOLLIN)
+                revents |= ZMQ_POLLIN;
+            if (ready [i].events & EPOLLOUT)
+                revents |= ZMQ_POLLOUT;
+            if (ready [i].events & ~(EPOLLIN | EPOLLOUT))
+                revents |= ZMQ_POLLERR;
+
+            //  Errors are reported even if not requested, same as zmq_poll
+            //  does. Otherwise a hung up descriptor, signaled on each call,
+            //  would keep the loop spinning.
+            revents &= item->events | ZMQ_POLLERR;
+            if (revents) {
+                events_ [found].socket = NULL;
+                events_ [found].fd = item->fd;
+                events_ [found].user_data = item->user_data;
+                events_ [found].events = revents;
+                found++;
+            }
+        }
+
+        //  All the sockets are up to date now, so their state can be read
+        //  without processing commands. Only the sockets that may have
+        //  changed are checked. The ones found ready stay on the list, as
+        //  they are likely to be ready next time as well; checking a socket
+        //  that is not ready arms its pipes to signal the socket once it
+        //  becomes ready, so it can be dropped from the list.
+        size_t pos = 0;
+        while (pos != dirty.size () && found != n_events_) {
+            item_t *item = dirty [pos];
+            short revents = 0;
+            if (item->events & ZMQ_POLLOUT && item->socket->has_out ())
+                revents |= ZMQ_POLLOUT;
+            if (item->events & ZMQ_POLLIN && item->socket->has_in ())
+                revents |= ZMQ_POLLIN;
+            if (revents) {
+                events_ [found].socket = item->socket;
+                events_ [found].fd = item->fd;
+                events_ [found].user_data = item->user_data;
+                events_ [found].events = revents;
+                found++;
+                pos++;
+            }
+            else {
+                item->dirty = false;
+                dirty [pos] = dirty.back ();
+                dirty.pop_back ();
+            }
+        }
+
+        //  If there was no room for all the ready sockets, report the other
+        //  ones first next time.
+        if (found == n_events_ && pos != 0)
+            std::rotate (dirty.begin (), dirty.begin () + pos, dirty.end ());
+
+        if (found)
+            return found;
+        if (timeout_ == 0) {
+            errno = EAGAIN;
+            return -1;
+        }
+        first_pass = false;
+    }
+}
+
+#else
+
+int zmq::socket_poller_t::wait (zmq_poller_event_t *events_, int n_events_,
+    long timeout_)
+{
+    if (items.empty () && timeout_ < 0) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    if (rebuild) {
+        pollitems.resize (items.size ());
+        for (size_t i = 0; i != items.size (); i++) {
+            pollitems [i].socket = items [i]->socket;
+            pollitems [i].fd = items [i]->fd;
+            pollitems [i].events = items [i]->events;
+        }
+        rebuild = false;
+    }
+
+    int rc = zmq_poll (pollitems.empty () ? NULL : &pollitems [0],
+        (int) pollitems.size (), timeout_);
+    if (rc < 0)
+        return -1;
+    if (rc == 0) {
+        errno = EAGAIN;
+        return -1;
+    }
+
+    int found = 0;
+    for (size_t i = 0; i != pollitems.size () && found != n_events_; i++) {
+        if (pollitems [i].revents) {
+            events_ [found].socket = items [i]->socket;
+            events_ [found].fd = items [i]->fd;
+            events_ [found].user_data = items [i]->user_data;
+            events_ [found].events = pollitems [i].revents;
+            found++;
+        }
+    }
+    return found;
+}
+
+#endif
@@ -0,0 +1,127 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SOCKET_POLLER_HPP_INCLUDED__
+#define __ZMQ_SOCKET_POLLER_HPP_INCLUDED__
+
+//  poller.hpp decides which polling mechanism to use.
+#include "poller.hpp"
+
+#include <vector>
+#if defined ZMQ_USE_EPOLL
+#include <sys/epoll.h>
+#endif
+
+#include "fd.hpp"
+#include "stdint.hpp"
+#include "../include/zmq.h"
+
+namespace zmq
+{
+
+    class socket_base_t;
+
+    //  Set of sockets and file descriptors polled by the user. Unlike
+    //  zmq_poll, the poller keeps the file descriptors registered with the
+    //  OS between the calls. Where epoll is available, only the sockets that
+    //  may have changed their state since the last wait are checked: the
+    //  ones whose file descriptor was signaled, the ones the application
+    //  has used in the meantime and the ones that were ready last time.
+
+    class socket_poller_t
+    {
+    public:
+
+        socket_poller_t ();
+        ~socket_poller_t ();
+
+        //  Returns false if object is not a poller.
+        bool check_tag ();
+
+        int add (socket_base_t *socket_, void *user_data_, short events_);
+        int modify (socket_base_t *socket_, short events_);
+        int remove (socket_base_t *socket_);
+
+        int add_fd (fd_t fd_, void *user_data_, short events_);
+        int modify_fd (fd_t fd_, short events_);
+        int remove_fd (fd_t fd_);
+
+        //  Waits till some of the items are ready and stores up to
+        //  n_events_ of them in events_. Returns the number of events
+        //  stored, or -1 with errno set to EAGAIN if the timeout expired.
+        int wait (zmq_poller_event_t *events_, int n_events_, long timeout_);
+
+        struct item_t
+        {
+            socket_poller_t *poller;
+            socket_base_t *socket;
+            fd_t fd;
+            void *user_data;
+            short events;
+
+            //  True if the item is on the poller's list of items to check.
+            bool dirty;
+        };
+
+        //  Called by the socket when its state may have changed without its
+        //  file descriptor being signaled.
+        void touch (item_t *item_);
+
+    private:
+
+        typedef std::vector <item_t*> items_t;
+        items_t items;
+
+        //  Returns the position of the item for the socket, or the raw file
+        //  descriptor if socket_ is NULL.
+        items_t::iterator find (socket_base_t *socket_, fd_t fd_);
+
+        int add_item (socket_base_t *socket_, fd_t fd_, void *user_data_,
+            short events_);
+        int modify_item (socket_base_t *socket_, fd_t fd_, short events_);
+        int remove_item (socket_base_t *socket_, fd_t fd_);
+
+#if defined ZMQ_USE_EPOLL
+        //  Sets the epoll events for the item's file descriptor.
+        void set_events (item_t *item_, int op_);
+
+        fd_t epoll_fd;
+
+        //  Buffer for the events returned by epoll_wait.
+        std::vector <epoll_event> ready;
+
+        //  Socket items to check on the next wait.
+        items_t dirty;
+#else
+        //  The items in the form zmq_poll expects. Rebuilt when the set of
+        //  items changes.
+        std::vector <zmq_pollitem_t> pollitems;
+        bool rebuild;
+#endif
+
+        //  Used to check whether the object is a poller.
+        uint32_t tag;
+
+        socket_poller_t (const socket_poller_t&);
+        const socket_poller_t &operator = (const socket_poller_t&);
+    };
+
+}
+
+#endif
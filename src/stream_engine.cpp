@@ -30,6 +30,9 @@
 #include <netinet/in.h>
 #include <netdb.h>
 #include <fcntl.h>
+#if defined ZMQ_HAVE_UIO
+#include <sys/uio.h>
+#endif
 #endif
 
 #include <string.h>
@@ -135,6 +138,14 @@ void zmq::stream_engine_t::plug (io_thread_t *io_thread_,
     handle = add_fd (s);
     io_enabled = true;
 
+    //  The engine reports when reading or writing would block.
+    enable_edge_triggering (handle);
+
+    //  If the I/O thread is busy polling, let the kernel busy poll as well.
+    int so_busy_poll = io_thread_->get_poller ()->get_so_busy_poll ();
+    if (so_busy_poll)
+        set_busy_poll (s, so_busy_poll);
+
     //  Send the 'length' and 'flags' fields of the identity message.
     //  The 'length' field is encoded in the long format.
     outpos = greeting_output_buffer;
@@ -257,6 +268,13 @@ void zmq::stream_engine_t::out_event ()
             return;
         }
 
+#if defined ZMQ_HAVE_UIO
+        //  Once the greeting is sent, the encoded data are written using
+        //  a single writev call per batch. Larger message bodies are not
+        //  copied into the encoder's buffer on the way.
+        out_event_iov ();
+        return;
+#else
         outpos = NULL;
         encoder->get_data (&outpos, &outsize);
 
@@ -265,6 +283,7 @@ void zmq::stream_engine_t::out_event ()
             reset_pollout (handle);
             return;
         }
+#endif
     }
 
     //  If there are any data to write in write buffer, write as much as
@@ -298,6 +317,41 @@ void zmq::stream_engine_t::out_event ()
             terminate ();
 }
 
+#if defined ZMQ_HAVE_UIO
+
+void zmq::stream_engine_t::out_event_iov ()
+{
+    iovec *iov;
+    int iovcnt;
+    encoder->get_iov (&iov, &iovcnt);
+
+    //  If there is no data to send, stop polling for output.
+    if (iovcnt == 0) {
+        reset_pollout (handle);
+        return;
+    }
+
+    int nbytes = writev (iov, iovcnt);
+
+    //  IO error has occurred. We stop waiting for output events.
+    //  The engine is not terminated until we detect input error;
+    //  this is necessary to prevent losing incomming messages.
+    if (nbytes == -1) {
+        reset_pollout (handle);
+        if (unlikely (terminating))
+            terminate ();
+        return;
+    }
+
+    encoder->consume (nbytes);
+
+    if (unlikely (terminating))
+        if (!encoder->has_data ())
+            terminate ();
+}
+
+#endif
+
 void zmq::stream_engine_t::activate_out ()
 {
     set_pollout (handle);
@@ -505,6 +559,11 @@ int zmq::stream_engine_t::write (const void *data_, size_t size_)
 
     ssize_t nbytes = send (s, data_, size_, 0);
 
+    //  Let the poller know the socket's send buffer is full.
+    if ((nbytes >= 0 && (size_t) nbytes < size_) ||
+          (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+        out_would_block (handle);
+
     //  Several errors are OK. When speculative write is being done we may not
     //  be able to write a single byte from the socket. Also, SIGSTOP issued
     //  by a debugging tool can result in EINTR error.
@@ -532,6 +591,46 @@ int zmq::stream_engine_t::write (const void *data_, size_t size_)
 #endif
 }
 
+#if defined ZMQ_HAVE_UIO
+
+int zmq::stream_engine_t::writev (const iovec *iov_, int iovcnt_)
+{
+    ssize_t nbytes = ::writev (s, iov_, iovcnt_);
+
+    //  Let the poller know the socket's send buffer is full.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        out_would_block (handle);
+    else
+    if (nbytes >= 0) {
+        size_t size = 0;
+        for (int i = 0; i != iovcnt_; i++)
+            size += iov_ [i].iov_len;
+        if ((size_t) nbytes < size)
+            out_would_block (handle);
+    }
+
+    //  Several errors are OK. When speculative write is being done we may not
+    //  be able to write a single byte to the socket. Also, SIGSTOP issued
+    //  by a debugging tool can result in EINTR error.
+    if (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK ||
+          errno == EINTR))
+        return 0;
+
+    //  Signalise peer failure.
+    if (nbytes == -1) {
+        errno_assert (errno != EBADF
+                   && errno != EFAULT
+                   && errno != EINVAL
+                   && errno != ENOMEM
+                   && errno != ENOTSOCK);
+        return -1;
+    }
+
+    return (int) nbytes;
+}
+
+#endif
+
 int zmq::stream_engine_t::read (void *data_, size_t size_)
 {
 #ifdef ZMQ_HAVE_WINDOWS
@@ -566,6 +665,11 @@ int zmq::stream_engine_t::read (void *data_, size_t size_)
 
     ssize_t nbytes = recv (s, data_, size_, 0);
 
+    //  Let the poller know the socket's receive buffer was drained.
+    if ((nbytes >= 0 && (size_t) nbytes < size_) ||
+          (nbytes == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)))
+        in_would_block (handle);
+
     //  Several errors are OK. When speculative read is being done we may not
     //  be able to read a single byte from the socket. Also, SIGSTOP issued
     //  by a debugging tool can result in EINTR error.
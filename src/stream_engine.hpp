@@ -83,6 +83,15 @@ namespace zmq
         //  of error or orderly shutdown by the other peer -1 is returned.
         int write (const void *data_, size_t size_);
 
+#if defined ZMQ_HAVE_UIO
+        //  Same as write, except that the data are gathered from a list
+        //  of slices.
+        int writev (const iovec *iov_, int iovcnt_);
+
+        //  Writes the data from the encoder using writev.
+        void out_event_iov ();
+#endif
+
         //  Reads data from the socket (up to 'size' bytes). Returns the number
         //  of bytes actually read (even zero is to be considered to be
         //  a success). In case of error or orderly shutdown by the other
@@ -0,0 +1,284 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "timer_wheel.hpp"
+#include "i_poll_events.hpp"
+#include "err.hpp"
+
+zmq::timer_wheel_t::timer_wheel_t () :
+    free_timers (-1),
+    count (0),
+    current (0),
+    next ((uint64_t) -1)
+{
+    for (int i = 0; i != levels * slots; i++) {
+        heads [i] = -1;
+        tails [i] = -1;
+    }
+    for (int i = 0; i != levels; i++)
+        counts [i] = 0;
+    table.resize (64, -1);
+}
+
+zmq::timer_wheel_t::~timer_wheel_t ()
+{
+}
+
+void zmq::timer_wheel_t::add (uint64_t now_, int timeout_,
+    i_poll_events *sink_, int id_)
+{
+    //  Nothing happens till 'next', so the wheel can move to the present.
+    if (now_ > current && now_ < next)
+        current = now_;
+
+    //  Keep the hash table at most half full.
+    if ((size_t) (count + 1) * 2 > table.size ())
+        resize_table (table.size () * 2);
+
+    size_t pos = find (sink_, id_);
+    zmq_assert (table [pos] == -1);
+
+    //  Get a record from the pool.
+    int index;
+    if (free_timers != -1) {
+        index = free_timers;
+        free_timers = timers [index].next;
+    }
+    else {
+        index = (int) timers.size ();
+        timers.push_back (timer_t ());
+    }
+
+    //  Timers added while executing the timers due now expire on the next
+    //  tick at the earliest.
+    uint64_t expiration = now_ + timeout_;
+    if (expiration <= current)
+        expiration = current + 1;
+
+    timers [index].expiration = expiration;
+    timers [index].sink = sink_;
+    timers [index].id = id_;
+    table [pos] = index;
+    count++;
+    link (index);
+}
+
+bool zmq::timer_wheel_t::cancel (i_poll_events *sink_, int id_)
+{
+    size_t pos = find (sink_, id_);
+    int index = table [pos];
+    if (index == -1)
+        return false;
+
+    erase (pos);
+    unlink (index);
+    timers [index].next = free_timers;
+    free_timers = index;
+    count--;
+    if (!count)
+        next = (uint64_t) -1;
+    return true;
+}
+
+uint64_t zmq::timer_wheel_t::execute (uint64_t now_)
+{
+    while (count && next <= now_) {
+
+        //  Nothing happens between the current time and 'next'.
+        current = next;
+
+        //  Cascade the slots that start now, the uppermost level first.
+        for (int level = levels - 1; level != 0; level--)
+            if (!(current & (((uint64_t) 1 << (level * slot_bits)) - 1)))
+                cascade (level);
+
+        //  Execute the timers that are due. Note that the event handlers may
+        //  add and cancel timers, moving the records around.
+        const int slot = (int) (current & slot_mask);
+        while (heads [slot] != -1) {
+            int index = heads [slot];
+            i_poll_events *sink = timers [index].sink;
+            int id = timers [index].id;
+            erase (find (sink, id));
+            unlink (index);
+            timers [index].next = free_timers;
+            free_timers = index;
+            count--;
+            sink->timer_event (id);
+        }
+
+        next = count ? find_next () : (uint64_t) -1;
+    }
+
+    if (!count)
+        return 0;
+    if (now_ > current)
+        current = now_;
+    return next - current;
+}
+
+bool zmq::timer_wheel_t::empty ()
+{
+    return count == 0;
+}
+
+void zmq::timer_wheel_t::link (int index_)
+{
+    timer_t &timer = timers [index_];
+
+    //  Find the lowest level that covers the expiration. Timers expiring
+    //  even after the uppermost level wraps around are put into its last
+    //  slot and cascaded back into the same level till they are due.
+    uint64_t expiration = timer.expiration;
+    const uint64_t delta = expiration - current;
+    int level = 0;
+    while (level != levels - 1 && (delta >> ((level + 1) * slot_bits)))
+        level++;
+    if (delta >> (levels * slot_bits))
+        expiration = current + ((uint64_t) 1 << (levels * slot_bits)) - 1;
+
+    const int shift = level * slot_bits;
+    const int slot = level * slots + (int) ((expiration >> shift) & slot_mask);
+
+    //  Append the timer to the slot so that timers expiring at the same time
+    //  are executed in the order they were added.
+    timer.slot = slot;
+    timer.prev = tails [slot];
+    timer.next = -1;
+    if (tails [slot] != -1)
+        timers [tails [slot]].next = index_;
+    else
+        heads [slot] = index_;
+    tails [slot] = index_;
+    counts [level]++;
+
+    //  The slot has to be processed when the time reaches its start.
+    const uint64_t start = (expiration >> shift) << shift;
+    if (start < next)
+        next = start;
+}
+
+void zmq::timer_wheel_t::unlink (int index_)
+{
+    timer_t &timer = timers [index_];
+    if (timer.prev != -1)
+        timers [timer.prev].next = timer.next;
+    else
+        heads [timer.slot] = timer.next;
+    if (timer.next != -1)
+        timers [timer.next].prev = timer.prev;
+    else
+        tails [timer.slot] = timer.prev;
+    counts [timer.slot / slots]--;
+}
+
+void zmq::timer_wheel_t::cascade (int level_)
+{
+    const int slot = level_ * slots +
+        (int) ((current >> (level_ * slot_bits)) & slot_mask);
+    int index = heads [slot];
+    heads [slot] = -1;
+    tails [slot] = -1;
+    while (index != -1) {
+        int following = timers [index].next;
+        counts [level_]--;
+        link (index);
+        index = following;
+    }
+}
+
+uint64_t zmq::timer_wheel_t::find_next ()
+{
+    uint64_t result = (uint64_t) -1;
+
+    //  Level 0 holds the timers expiring within the next 255 milliseconds.
+    if (counts [0])
+        for (uint64_t time = current + 1; time != current + slots; time++)
+            if (heads [time & slot_mask] != -1) {
+                result = time;
+                break;
+            }
+
+    //  The slots of the upper levels start with the next one and end with
+    //  the current one which wrapped around.
+    for (int level = 1; level != levels; level++) {
+        if (!counts [level])
+            continue;
+        const int shift = level * slot_bits;
+        const uint64_t base = current >> shift;
+        for (uint64_t i = base + 1; i != base + slots + 1; i++)
+            if (heads [level * slots + (int) (i & slot_mask)] != -1) {
+                if ((i << shift) < result)
+                    result = i << shift;
+                break;
+            }
+    }
+
+    return result;
+}
+
+size_t zmq::timer_wheel_t::hash (i_poll_events *sink_, int id_)
+{
+    uint32_t h = (uint32_t) ((uintptr_t) sink_ >> 3) * 2654435761u;
+    h ^= (uint32_t) id_ * 2246822519u;
+    h ^= h >> 15;
+    return (size_t) h;
+}
+
+size_t zmq::timer_wheel_t::find (i_poll_events *sink_, int id_)
+{
+    const size_t mask = table.size () - 1;
+    size_t pos = hash (sink_, id_) & mask;
+    while (table [pos] != -1) {
+        const timer_t &timer = timers [table [pos]];
+        if (timer.sink == sink_ && timer.id == id_)
+            break;
+        pos = (pos + 1) & mask;
+    }
+    return pos;
+}
+
+void zmq::timer_wheel_t::erase (size_t pos_)
+{
+    //  Move the following entries of the cluster back, unless that would
+    //  put them before the position they hash to.
+    const size_t mask = table.size () - 1;
+    size_t hole = pos_;
+    size_t pos = (pos_ + 1) & mask;
+    while (table [pos] != -1) {
+        const timer_t &timer = timers [table [pos]];
+        const size_t home = hash (timer.sink, timer.id) & mask;
+        if (((pos - home) & mask) >= ((pos - hole) & mask)) {
+            table [hole] = table [pos];
+            hole = pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+    table [hole] = -1;
+}
+
+void zmq::timer_wheel_t::resize_table (size_t size_)
+{
+    table_t old;
+    old.swap (table);
+    table.resize (size_, -1);
+    for (table_t::iterator it = old.begin (); it != old.end (); ++it)
+        if (*it != -1)
+            table [find (timers [*it].sink, timers [*it].id)] = *it;
+}
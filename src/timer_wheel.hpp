@@ -0,0 +1,138 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+#define __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+
+#include <vector>
+#include <stddef.h>
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+
+    struct i_poll_events;
+
+    //  Hierarchical timer wheel. Timers live in 4 levels of 256 slots each,
+    //  level N holding the timers that expire within 256^(N+1) milliseconds.
+    //  As the time passes, the slots of the upper levels are cascaded into
+    //  the lower ones. Adding and cancelling a timer is O(1): the timer
+    //  records are doubly linked into the slots and found by their sink and
+    //  ID using an open addressing hash table. The records are pooled, so
+    //  there is no memory allocation per timer.
+
+    class timer_wheel_t
+    {
+    public:
+
+        timer_wheel_t ();
+        ~timer_wheel_t ();
+
+        //  Adds a timer expiring timeout_ milliseconds after now_. There may
+        //  be at most one timer with a given sink and ID at a time.
+        void add (uint64_t now_, int timeout_, zmq::i_poll_events *sink_,
+            int id_);
+
+        //  Cancels the timer created by sink_ with ID equal to id_. Returns
+        //  false if there is no such timer.
+        bool cancel (zmq::i_poll_events *sink_, int id_);
+
+        //  Invokes timer_event on the sinks of the timers that expired
+        //  at now_. Returns the number of milliseconds till the wheel has
+        //  to be executed again (at least 1), or 0 meaning "no timers".
+        uint64_t execute (uint64_t now_);
+
+        //  Returns true if there are no timers.
+        bool empty ();
+
+    private:
+
+        enum {
+            levels = 4,
+            slot_bits = 8,
+            slots = 1 << slot_bits,
+            slot_mask = slots - 1
+        };
+
+        struct timer_t
+        {
+            uint64_t expiration;
+            zmq::i_poll_events *sink;
+            int id;
+
+            //  Slot the timer is linked into and its neighbours there. Free
+            //  records are linked into the free list using 'next'.
+            int slot;
+            int prev;
+            int next;
+        };
+
+        //  Links the timer into the slot matching its expiration.
+        void link (int index_);
+
+        //  Unlinks the timer from its slot.
+        void unlink (int index_);
+
+        //  Moves the timers from the current slot of the level to the lower
+        //  levels.
+        void cascade (int level_);
+
+        //  Returns the earliest time at which a timer may expire or a slot
+        //  has to be cascaded.
+        uint64_t find_next ();
+
+        //  Hash table helpers. Find returns the position of the timer in the
+        //  table or the empty position where it would be inserted.
+        size_t hash (zmq::i_poll_events *sink_, int id_);
+        size_t find (zmq::i_poll_events *sink_, int id_);
+        void erase (size_t pos_);
+        void resize_table (size_t size_);
+
+        //  Pool of timer records and the head of the list of free ones.
+        typedef std::vector <timer_t> timers_t;
+        timers_t timers;
+        int free_timers;
+
+        //  First and last timer in each slot, -1 meaning empty.
+        int heads [levels * slots];
+        int tails [levels * slots];
+
+        //  Number of timers at each level and in total.
+        int counts [levels];
+        int count;
+
+        //  All the timers expiring up to this time have been executed.
+        uint64_t current;
+
+        //  No timer expires and no slot has to be cascaded before this time.
+        //  Cancelling timers may leave it too early, never too late.
+        uint64_t next;
+
+        //  Indices of timers hashed by sink and ID, -1 meaning empty.
+        typedef std::vector <int> table_t;
+        table_t table;
+
+        timer_wheel_t (const timer_wheel_t&);
+        const timer_wheel_t &operator = (const timer_wheel_t&);
+    };
+
+}
+
+#endif
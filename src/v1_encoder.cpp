@@ -98,6 +98,7 @@ bool zmq::v1_encoder_t::size_ready ()
 {
     //  Write message body into the buffer.
     next_step (in_progress.data (), in_progress.size (),
-        &v1_encoder_t::message_ready, !(in_progress.flags () & msg_t::more));
+        &v1_encoder_t::message_ready, !(in_progress.flags () & msg_t::more),
+        &in_progress);
     return true;
 }
@@ -20,6 +20,7 @@
 */
 
 #include <string.h>
+#include <algorithm>
 
 #include "xpub.hpp"
 #include "pipe.hpp"
@@ -29,6 +30,11 @@
 zmq::xpub_t::xpub_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_),
     verbose(false),
+    conflate (false),
+    conflate_prefix (0),
+    cache_size (0),
+    cache_prefix (0),
+    replay_pipe (NULL),
     more (false)
 {
     options.type = ZMQ_XPUB;
@@ -45,8 +51,10 @@ void zmq::xpub_t::xattach_pipe (pipe_t *pipe_, bool icanhasall_)
 
     //  If icanhasall_ is specified, the caller would like to subscribe
     //  to all data on this pipe, implicitly.
-    if (icanhasall_)
-        subscriptions.add (NULL, 0, pipe_);
+    if (icanhasall_) {
+        subscriptions.add (NULL, 0, pipe_, pipe_->get_slot ());
+        replay (pipe_, NULL, 0);
+    }
 
     //  The pipe is active when attached. Let's read the subscriptions from
     //  it, if any.
@@ -66,8 +74,11 @@ void zmq::xpub_t::xread_activated (pipe_t *pipe_)
             bool unique;
             if (*data == 0)
                 unique = subscriptions.rm (data + 1, size - 1, pipe_);
-            else
-                unique = subscriptions.add (data + 1, size - 1, pipe_);
+            else {
+                unique = subscriptions.add (data + 1, size - 1, pipe_,
+                    pipe_->get_slot ());
+                replay (pipe_, data + 1, size - 1);
+            }
 
             //  If the subscription is not a duplicate store it so that it can be
             //  passed to used on next recv call. (Unsubscribe is not verbose.)
@@ -87,15 +98,36 @@ void zmq::xpub_t::xwrite_activated (pipe_t *pipe_)
 int zmq::xpub_t::xsetsockopt (int option_, const void *optval_,
     size_t optvallen_)
 {
-    if (option_ != ZMQ_XPUB_VERBOSE) {
+    if (option_ != ZMQ_XPUB_VERBOSE && option_ != ZMQ_XPUB_CONFLATE &&
+          option_ != ZMQ_XPUB_CONFLATE_PREFIX &&
+          option_ != ZMQ_XPUB_CACHE_SIZE && option_ != ZMQ_XPUB_CACHE_PREFIX) {
         errno = EINVAL;
         return -1;
     }
+    //  None of the options takes a negative value. The sizes would wrap
+    //  around when converted to size_t.
     if (optvallen_ != sizeof (int) || *static_cast <const int*> (optval_) < 0) {
         errno = EINVAL;
         return -1;
     }
-    verbose = *static_cast <const int*> (optval_);
+    int value = *static_cast <const int*> (optval_);
+    if (option_ == ZMQ_XPUB_VERBOSE)
+        verbose = value;
+    else
+    if (option_ == ZMQ_XPUB_CONFLATE || option_ == ZMQ_XPUB_CONFLATE_PREFIX) {
+        if (option_ == ZMQ_XPUB_CONFLATE)
+            conflate = value != 0;
+        else
+            conflate_prefix = (size_t) value;
+        dist.set_conflate (conflate, conflate_prefix);
+    }
+    else {
+        if (option_ == ZMQ_XPUB_CACHE_SIZE)
+            cache_size = (size_t) value;
+        else
+            cache_prefix = (size_t) value;
+        cache.set_limits (cache_size, cache_prefix);
+    }
     return 0;
 }
 
@@ -106,13 +138,14 @@ void zmq::xpub_t::xterminated (pipe_t *pipe_)
     //  upstream.
     subscriptions.rm (pipe_, send_unsubscription, this);
 
-    dist.terminated (pipe_);
-}
+    //  Forget about the replays the pipe is still waiting for.
+    replays_t::size_type live = 0;
+    for (replays_t::size_type i = 0; i != replays.size (); i++)
+        if (replays [i].first != pipe_)
+            replays [live++] = replays [i];
+    replays.resize (live);
 
-void zmq::xpub_t::mark_as_matching (pipe_t *pipe_, void *arg_)
-{
-    xpub_t *self = (xpub_t*) arg_;
-    self->dist.match (pipe_);
+    dist.terminated (pipe_);
 }
 
 int zmq::xpub_t::xsend (msg_t *msg_, int flags_)
@@ -120,23 +153,34 @@ int zmq::xpub_t::xsend (msg_t *msg_, int flags_)
     bool msg_more = msg_->flags () & msg_t::more ? true : false;
 
     //  For the first part of multi-part message, find the matching pipes.
-    if (!more)
+    if (!more) {
+        std::fill (matching.begin (), matching.end (), 0);
         subscriptions.match ((unsigned char*) msg_->data (), msg_->size (),
-            mark_as_matching, this);
+            matching);
+    }
 
-    //  Send the message to all the pipes that were marked as matching
+    //  Keep a copy of the message for the future subscribers.
+    if (cache.enabled ())
+        cache.store (msg_, !more);
+
+    //  Send the message to all the pipes that were found matching
     //  in the previous step.
-    int rc = dist.send_to_matching (msg_, flags_);
+    int rc = dist.send_to_slots (msg_, flags_, matching);
     if (rc != 0)
         return rc;
 
-    //  If we are at the end of multi-part message we can mark all the pipes
-    //  as non-matching.
-    if (!msg_more)
-        dist.unmatch ();
-
     more = msg_more;
 
+    //  Once the message is complete, catch up with the replays postponed
+    //  while it was being sent.
+    if (!more && !replays.empty ()) {
+        replays_t postponed;
+        postponed.swap (replays);
+        for (replays_t::size_type i = 0; i != postponed.size (); i++)
+            replay (postponed [i].first, postponed [i].second.data (),
+                postponed [i].second.size ());
+    }
+
     return 0;
 }
 
@@ -145,6 +189,22 @@ bool zmq::xpub_t::xhas_out ()
     return dist.has_out ();
 }
 
+void zmq::xpub_t::xbegin_batch ()
+{
+    dist.begin_batch ();
+}
+
+void zmq::xpub_t::xend_batch ()
+{
+    dist.end_batch ();
+}
+
+void zmq::xpub_t::xget_drops (uint64_t *hwm_drops_, uint64_t *unroutable_drops_)
+{
+    *hwm_drops_ = dist.get_drops ();
+    *unroutable_drops_ = 0;
+}
+
 int zmq::xpub_t::xrecv (msg_t *msg_, int flags_)
 {
     // flags_ is unused
@@ -171,6 +231,43 @@ bool zmq::xpub_t::xhas_in ()
     return !pending.empty ();
 }
 
+void zmq::xpub_t::replay (pipe_t *pipe_, const unsigned char *data_,
+    size_t size_)
+{
+    if (!cache.enabled ())
+        return;
+
+    //  Messages can't be slipped in between the parts of a message.
+    if (more) {
+        replays.push_back (std::make_pair (pipe_, blob_t (data_, size_)));
+        return;
+    }
+
+    replay_pipe = pipe_;
+    cache.match (data_, size_, send_cached, this);
+    replay_pipe = NULL;
+}
+
+void zmq::xpub_t::send_cached (msg_t *parts_, size_t count_, void *arg_)
+{
+    xpub_t *self = (xpub_t*) arg_;
+
+    //  If the first part doesn't get through, neither do the others.
+    for (size_t i = 0; i != count_; i++) {
+        msg_t msg;
+        int rc = msg.init ();
+        errno_assert (rc == 0);
+        rc = msg.copy (parts_ [i]);
+        errno_assert (rc == 0);
+        if (!self->dist.send_to_pipe (self->replay_pipe, &msg)) {
+            rc = msg.close ();
+            errno_assert (rc == 0);
+            zmq_assert (i == 0);
+            return;
+        }
+    }
+}
+
 void zmq::xpub_t::send_unsubscription (unsigned char *data_, size_t size_,
     void *arg_)
 {
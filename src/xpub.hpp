@@ -23,12 +23,16 @@
 
 #include <deque>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "mtrie.hpp"
 #include "array.hpp"
+#include "blob.hpp"
 #include "dist.hpp"
+#include "lvc.hpp"
 
 namespace zmq
 {
@@ -49,6 +53,8 @@ namespace zmq
         //  Implementations of virtual functions from socket_base_t.
         void xattach_pipe (zmq::pipe_t *pipe_, bool icanhasall_ = false);
         int xsend (zmq::msg_t *msg_, int flags_);
+        void xbegin_batch ();
+        void xend_batch ();
         bool xhas_out ();
         int xrecv (zmq::msg_t *msg_, int flags_);
         bool xhas_in ();
@@ -56,6 +62,7 @@ namespace zmq
         void xwrite_activated (zmq::pipe_t *pipe_);
         int xsetsockopt (int option_, const void *optval_, size_t optvallen_);
         void xterminated (zmq::pipe_t *pipe_);
+        void xget_drops (uint64_t *hwm_drops_, uint64_t *unroutable_drops_);
 
     private:
 
@@ -64,12 +71,22 @@ namespace zmq
         static void send_unsubscription (unsigned char *data_, size_t size_,
             void *arg_);
 
-        //  Function to be applied to each matching pipes.
-        static void mark_as_matching (zmq::pipe_t *pipe_, void *arg_);
+        //  Sends the cached messages matching the subscription to the pipe
+        //  that has just subscribed.
+        void replay (zmq::pipe_t *pipe_, const unsigned char *data_,
+            size_t size_);
+
+        //  Function to be applied to the cache to send the matching messages
+        //  to the pipe being replayed to.
+        static void send_cached (zmq::msg_t *parts_, size_t count_,
+            void *arg_);
 
         //  List of all subscriptions mapped to corresponding pipes.
         mtrie_t subscriptions;
 
+        //  Slots of the pipes matching the message being sent.
+        bitmap_t matching;
+
         //  Distributor of messages holding the list of outbound pipes.
         dist_t dist;
 
@@ -77,12 +94,31 @@ namespace zmq
         // unique ones
         bool verbose;
 
+        //  If true, the messages for the peers that have reached the high
+        //  watermark are conflated per topic rather than dropped. Topics
+        //  are conflate_prefix bytes long, 0 meaning the whole first part.
+        bool conflate;
+        size_t conflate_prefix;
+
+        //  Latest message published on each topic, replayed to the new
+        //  subscribers.
+        lvc_t cache;
+        size_t cache_size;
+        size_t cache_prefix;
+
+        //  Subscriptions whose cached messages can't be replayed until the
+        //  multi-part message being sent at the moment is complete.
+        typedef std::vector <std::pair <zmq::pipe_t*, blob_t> > replays_t;
+        replays_t replays;
+
+        //  Pipe the cached messages are being replayed to.
+        zmq::pipe_t *replay_pipe;
+
         //  True if we are in the middle of sending a multi-part message.
         bool more;
 
         //  List of pending (un)subscriptions, ie. those that were already
         //  applied to the trie, but not yet received by the user.
-        typedef std::basic_string <unsigned char> blob_t;
         typedef std::deque <blob_t> pending_t;
         pending_t pending;
 
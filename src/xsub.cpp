@@ -99,12 +99,15 @@ int zmq::xsub_t::xsend (msg_t *msg_, int flags_)
 	// however this is alread done on the XPUB side and
 	// doing it here as well breaks ZMQ_XPUB_VERBOSE
 	// when there are forwarding devices involved
-        subscriptions.add (data + 1, size - 1);
+        if (subscriptions.add (data + 1, size - 1))
+            matcher.add (data + 1, size - 1);
         return dist.send_to_all (msg_, flags_);
     }
     else {
-        if (subscriptions.rm (data + 1, size - 1))
+        if (subscriptions.rm (data + 1, size - 1)) {
+            matcher.rm (data + 1, size - 1);
             return dist.send_to_all (msg_, flags_);
+        }
     }
 
     int rc = msg_->close ();
@@ -207,6 +210,8 @@ bool zmq::xsub_t::xhas_in ()
 
 bool zmq::xsub_t::match (msg_t *msg_)
 {
+    if (matcher.usable ())
+        return matcher.check ((unsigned char*) msg_->data (), msg_->size ());
     return subscriptions.check ((unsigned char*) msg_->data (), msg_->size ());
 }
 
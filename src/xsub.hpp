@@ -26,6 +26,7 @@
 #include "dist.hpp"
 #include "fq.hpp"
 #include "trie.hpp"
+#include "prefix_matcher.hpp"
 
 namespace zmq
 {
@@ -74,6 +75,10 @@ namespace zmq
         //  The repository of subscriptions.
         trie_t subscriptions;
 
+        //  Unique subscriptions, used to match the messages instead of the
+        //  trie when there are many short ones.
+        prefix_matcher_t matcher;
+
         //  If true, 'message' contains a matching message to return on the
         //  next recv call.
         bool has_message;
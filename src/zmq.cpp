@@ -72,6 +72,7 @@ struct iovec {
 
 #include "proxy.hpp"
 #include "socket_base.hpp"
+#include "socket_poller.hpp"
 #include "stdint.hpp"
 #include "config.hpp"
 #include "likely.hpp"
@@ -411,6 +412,56 @@ int zmq_sendiov (void *s_, iovec *a_, size_t count_, int flags_)
     return rc; 
 }
 
+// Send multiple messages without copying the data.
+//
+// Same as zmq_sendiov, except that each iovec is attached to the message
+// rather than being copied into it. The buffers are owned by the library
+// from now on and ffn_ is called for each of them once it is no longer
+// needed. If sending fails, ffn_ is called for the buffers that were not
+// passed to the socket as well, so that the caller doesn't have to track
+// which parts were sent.
+//
+int zmq_sendiov_data (void *s_, iovec *a_, size_t count_, int flags_,
+    zmq_free_fn *ffn_, void *hint_)
+{
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return -1;
+    }
+    int rc = 0;
+    zmq_msg_t msg;
+    zmq::socket_base_t *s = (zmq::socket_base_t *) s_;
+
+    size_t i = 0;
+    for (; i < count_; ++i) {
+        rc = zmq_msg_init_data (&msg, a_[i].iov_base, a_[i].iov_len,
+            ffn_, hint_);
+        if (rc != 0) {
+            rc = -1;
+            break;
+        }
+        if (i == count_ - 1)
+            flags_ = flags_ & ~ZMQ_SNDMORE;
+        rc = s_sendmsg (s, &msg, flags_);
+        if (unlikely (rc < 0)) {
+           int err = errno;
+           int rc2 = zmq_msg_close (&msg);
+           errno_assert (rc2 == 0);
+           errno = err;
+           rc = -1;
+           ++i;
+           break;
+        }
+    }
+
+    //  Release the buffers that haven't made it into the socket.
+    if (rc < 0 && ffn_)
+        for (; i < count_; ++i)
+            ffn_ (a_[i].iov_base, hint_);
+
+    return rc;
+}
+
 // Receiving functions.
 
 static int
@@ -460,6 +511,48 @@ int zmq_recv (void *s_, void *buf_, size_t len_, int flags_)
     return nbytes;
 }
 
+// Send a batch of messages.
+//
+// Each message in msgs_ is sent as a separate single-part message. Waits
+// until the first message can be sent as specified by flags_ and then sends
+// as many of the subsequent messages as possible without blocking. Pipes
+// are flushed once per batch. Returns the number of messages sent; the
+// messages that were not sent are left untouched.
+//
+int zmq_send_batch (void *s_, zmq_msg_t *msgs_, int count_, int flags_)
+{
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return -1;
+    }
+    if (!msgs_ || count_ <= 0 || (flags_ & ZMQ_SNDMORE)) {
+        errno = EINVAL;
+        return -1;
+    }
+    zmq::socket_base_t *s = (zmq::socket_base_t *) s_;
+    return s->send_batch ((zmq::msg_t*) msgs_, count_, flags_);
+}
+
+// Receive a batch of message parts.
+//
+// Waits for the first message part as specified by flags_ and then stores
+// all the subsequent parts that are immediately available, up to count_
+// parts in total. Returns the number of parts stored in msgs_.
+//
+int zmq_recv_batch (void *s_, zmq_msg_t *msgs_, int count_, int flags_)
+{
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return -1;
+    }
+    if (!msgs_ || count_ <= 0) {
+        errno = EINVAL;
+        return -1;
+    }
+    zmq::socket_base_t *s = (zmq::socket_base_t *) s_;
+    return s->recv_batch ((zmq::msg_t*) msgs_, count_, flags_);
+}
+
 // Receive a multi-part message
 // 
 // Receives up to *count_ parts of a multi-part message.
@@ -964,9 +1057,121 @@ int zmq_poll (zmq_pollitem_t *items_, int nitems_, long timeout_)
 #undef ZMQ_POLL_BASED_ON_POLL
 #endif
 
+//  The persistent poller
+
+void *zmq_poller_new (void)
+{
+    zmq::socket_poller_t *poller = new (std::nothrow) zmq::socket_poller_t;
+    alloc_assert (poller);
+    return poller;
+}
+
+int zmq_poller_destroy (void **poller_)
+{
+    if (!poller_ || !*poller_ ||
+          !((zmq::socket_poller_t*) *poller_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    delete (zmq::socket_poller_t*) *poller_;
+    *poller_ = NULL;
+    return 0;
+}
+
+static bool check_poller (void *poller_)
+{
+    if (!poller_ || !((zmq::socket_poller_t*) poller_)->check_tag ()) {
+        errno = EFAULT;
+        return false;
+    }
+    return true;
+}
+
+static bool check_socket (void *s_)
+{
+    if (!s_ || !((zmq::socket_base_t*) s_)->check_tag ()) {
+        errno = ENOTSOCK;
+        return false;
+    }
+    return true;
+}
+
+int zmq_poller_add (void *poller_, void *s_, void *user_data_, short events_)
+{
+    if (!check_poller (poller_) || !check_socket (s_))
+        return -1;
+    return ((zmq::socket_poller_t*) poller_)->add (
+        (zmq::socket_base_t*) s_, user_data_, events_);
+}
+
+int zmq_poller_modify (void *poller_, void *s_, short events_)
+{
+    if (!check_poller (poller_) || !check_socket (s_))
+        return -1;
+    return ((zmq::socket_poller_t*) poller_)->modify (
+        (zmq::socket_base_t*) s_, events_);
+}
+
+int zmq_poller_remove (void *poller_, void *s_)
+{
+    if (!check_poller (poller_) || !check_socket (s_))
+        return -1;
+    return ((zmq::socket_poller_t*) poller_)->remove (
+        (zmq::socket_base_t*) s_);
+}
+
+int zmq_poller_add_fd (void *poller_, zmq::fd_t fd_, void *user_data_,
+    short events_)
+{
+    if (!check_poller (poller_))
+        return -1;
+    return ((zmq::socket_poller_t*) poller_)->add_fd (fd_, user_data_,
+        events_);
+}
+
+int zmq_poller_modify_fd (void *poller_, zmq::fd_t fd_, short events_)
+{
+    if (!check_poller (poller_))
+        return -1;
+    return ((zmq::socket_poller_t*) poller_)->modify_fd (fd_, events_);
+}
+
+int zmq_poller_remove_fd (void *poller_, zmq::fd_t fd_)
+{
+    if (!check_poller (poller_))
+        return -1;
+    return ((zmq::socket_poller_t*) poller_)->remove_fd (fd_);
+}
+
+int zmq_poller_wait_all (void *poller_, zmq_poller_event_t *events_,
+    int n_events_, long timeout_)
+{
+    if (!check_poller (poller_))
+        return -1;
+    if (!events_ || n_events_ < 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    return ((zmq::socket_poller_t*) poller_)->wait (events_, n_events_,
+        timeout_);
+}
+
 //  The proxy functionality
 
-int zmq_proxy (void *frontend_, void *backend_, void *control_)
+int zmq_proxy (void *frontend_, void *backend_, void *capture_)
+{
+    if (!frontend_ || !backend_) {
+        errno = EFAULT;
+        return -1;
+    }
+    return zmq::proxy (
+        (zmq::socket_base_t*) frontend_,
+        (zmq::socket_base_t*) backend_,
+        (zmq::socket_base_t*) capture_, NULL);
+}
+
+int zmq_proxy_steerable (void *frontend_, void *backend_, void *capture_,
+    void *control_)
 {
     if (!frontend_ || !backend_) {
         errno = EFAULT;
@@ -975,6 +1180,7 @@ int zmq_proxy (void *frontend_, void *backend_, void *control_)
     return zmq::proxy (
         (zmq::socket_base_t*) frontend_,
         (zmq::socket_base_t*) backend_,
+        (zmq::socket_base_t*) capture_,
         (zmq::socket_base_t*) control_);
 }
 
@@ -984,7 +1190,7 @@ int zmq_device (int type, void *frontend_, void *backend_)
 {
     return zmq::proxy (
         (zmq::socket_base_t*) frontend_,
-        (zmq::socket_base_t*) backend_, NULL);
+        (zmq::socket_base_t*) backend_, NULL, NULL);
 }
 
 //  Callback to free socket event data
@@ -0,0 +1,118 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+//  Number of times the free function of the published messages was called.
+//  Only read once the context is terminated and the I/O threads are gone.
+static int released = 0;
+
+static void release (void *, void *)
+{
+    released++;
+}
+
+static void publish (void *ctx_, const char *addr_, int subscribers_,
+    int count_)
+{
+    void *pub = zmq_socket (ctx_, ZMQ_XPUB);
+    assert (pub);
+    int verbose = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_XPUB_VERBOSE, &verbose, sizeof (verbose));
+    assert (rc == 0);
+    rc = zmq_bind (pub, addr_);
+    assert (rc == 0);
+
+    void **subs = new void* [subscribers_];
+    for (int i = 0; i != subscribers_; i++) {
+        subs [i] = zmq_socket (ctx_, ZMQ_SUB);
+        assert (subs [i]);
+        rc = zmq_setsockopt (subs [i], ZMQ_SUBSCRIBE, "", 0);
+        assert (rc == 0);
+        rc = zmq_connect (subs [i], addr_);
+        assert (rc == 0);
+    }
+
+    //  Wait for all the subscriptions to arrive.
+    for (int i = 0; i != subscribers_; i++) {
+        char sub [1];
+        rc = zmq_recv (pub, sub, sizeof (sub), 0);
+        assert (rc == 1 && sub [0] == 1);
+    }
+
+    //  Alternate user-supplied buffers, whose releases are counted, with
+    //  buffers allocated by the library.
+    static char data [] = "a message too long to be copied around";
+    for (int i = 0; i != count_; i++) {
+        zmq_msg_t msg;
+        if (i % 2)
+            rc = zmq_msg_init_data (&msg, data, sizeof (data), release, NULL);
+        else {
+            rc = zmq_msg_init_size (&msg, sizeof (data));
+            if (rc == 0)
+                memcpy (zmq_msg_data (&msg), data, sizeof (data));
+        }
+        assert (rc == 0);
+        rc = zmq_msg_send (&msg, pub, 0);
+        assert (rc == (int) sizeof (data));
+    }
+
+    for (int i = 0; i != subscribers_; i++) {
+        for (int j = 0; j != count_; j++) {
+            char buf [sizeof (data)];
+            rc = zmq_recv (subs [i], buf, sizeof (buf), 0);
+            assert (rc == (int) sizeof (data));
+            assert (memcmp (buf, data, sizeof (data)) == 0);
+        }
+        rc = zmq_close (subs [i]);
+        assert (rc == 0);
+    }
+    delete [] subs;
+
+    rc = zmq_close (pub);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    fprintf (stderr, "test_io_batch_releases running...\n");
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BATCH_RELEASES) ==
+        ZMQ_IO_BATCH_RELEASES_DFLT);
+    int rc = zmq_ctx_set (ctx, ZMQ_IO_BATCH_RELEASES, 1);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BATCH_RELEASES) == 1);
+    rc = zmq_ctx_set (ctx, ZMQ_IO_THREADS, 2);
+    assert (rc == 0);
+
+    //  A single subscriber doesn't share the messages at all, many of them
+    //  make the I/O threads close copies of the same message in turns.
+    publish (ctx, "tcp://127.0.0.1:5560", 1, 100);
+    publish (ctx, "tcp://127.0.0.1:5561", 50, 1000);
+
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+
+    //  Every message must have been released exactly once.
+    assert (released == 550);
+
+    return 0 ;
+}
@@ -0,0 +1,76 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+int main (void)
+{
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BUSY_POLL) == ZMQ_IO_BUSY_POLL_DFLT);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BUSY_POLL_THREADS) ==
+        ZMQ_IO_BUSY_POLL_THREADS_DFLT);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BUSY_POLL_SOCKETS) ==
+        ZMQ_IO_BUSY_POLL_SOCKETS_DFLT);
+    int rc = zmq_ctx_set (ctx, ZMQ_IO_BUSY_POLL, -1);
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Two I/O threads, the first one busy polling for 1ms after each
+    //  batch of events.
+    rc = zmq_ctx_set (ctx, ZMQ_IO_THREADS, 2);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_IO_BUSY_POLL, 1000);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_IO_BUSY_POLL_THREADS, 1);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_IO_BUSY_POLL_SOCKETS, 1);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BUSY_POLL) == 1000);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BUSY_POLL_THREADS) == 1);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_BUSY_POLL_SOCKETS) == 1);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+
+    for (int i = 0; i != 100; i++)
+        bounce (sb, sc);
+
+    int busy = zmq_ctx_get (ctx, ZMQ_IO_BUSY_ITERATIONS);
+    int idle = zmq_ctx_get (ctx, ZMQ_IO_IDLE_ITERATIONS);
+    assert (busy >= 0 && idle >= 0);
+#if defined __linux__
+    //  Busy polling is implemented by the epoll poller.
+    assert (busy > 0 && idle > 0);
+#endif
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
@@ -0,0 +1,112 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include <stdlib.h>
+
+static void transfer (void *ctx_, const char *addr_)
+{
+    void *sb = zmq_socket (ctx_, ZMQ_PULL);
+    assert (sb);
+    int hwm = 10;
+    int rc = zmq_setsockopt (sb, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_bind (sb, addr_);
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_setsockopt (sc, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_connect (sc, addr_);
+    assert (rc == 0);
+
+    //  Messages larger than the socket buffers make the writes and reads
+    //  block half way through; the low watermarks make the engines stop
+    //  and resume reading.
+    const size_t size = 1024 * 1024;
+    char *buf = (char*) malloc (size);
+    assert (buf);
+    const int count = 50;
+    const int lag = 5;
+    for (int i = 0; i != count + lag; i++) {
+        if (i < count) {
+            memset (buf, i, size);
+            rc = zmq_send (sc, buf, size, 0);
+            assert (rc == (int) size);
+        }
+        if (i >= lag) {
+            rc = zmq_recv (sb, buf, size, 0);
+            assert (rc == (int) size);
+            assert (buf [0] == (char) (i - lag) &&
+                buf [size - 1] == (char) (i - lag));
+        }
+    }
+    free (buf);
+
+    //  Small messages, one by one.
+    for (int i = 0; i != 1000; i++) {
+        rc = zmq_send (sc, &i, sizeof (i), 0);
+        assert (rc == sizeof (i));
+        int val;
+        rc = zmq_recv (sb, &val, sizeof (val), 0);
+        assert (rc == sizeof (val));
+        assert (val == i);
+    }
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    assert (zmq_ctx_get (ctx, ZMQ_IO_EDGE_TRIGGERED) ==
+        ZMQ_IO_EDGE_TRIGGERED_DFLT);
+    int rc = zmq_ctx_set (ctx, ZMQ_IO_EDGE_TRIGGERED, 1);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_IO_EDGE_TRIGGERED) == 1);
+
+    void *sb = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sb);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+    for (int i = 0; i != 100; i++)
+        bounce (sb, sc);
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+
+    transfer (ctx, "tcp://127.0.0.1:5561");
+#if !defined _WIN32
+    transfer (ctx, "ipc:///tmp/test_io_edge_triggered");
+#endif
+
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
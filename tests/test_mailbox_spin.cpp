@@ -0,0 +1,119 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include <pthread.h>
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+#define ROUNDTRIPS 10000
+
+extern "C"
+{
+    static void *worker (void *s_)
+    {
+        //  Echo the messages back, waiting for them with zmq_poll so that
+        //  the file descriptor based wake-up path gets exercised as well.
+        zmq_pollitem_t items [] = {{s_, 0, ZMQ_POLLIN, 0}};
+        for (int i = 0; i != ROUNDTRIPS; i++) {
+            int rc = zmq_poll (items, 1, -1);
+            assert (rc == 1);
+            char buf [8];
+            rc = zmq_recv (s_, buf, sizeof (buf), ZMQ_DONTWAIT);
+            assert (rc == 4);
+            rc = zmq_send (s_, buf, 4, 0);
+            assert (rc == 4);
+        }
+        return NULL;
+    }
+}
+
+static void pingpong (void *ctx_, const char *addr_)
+{
+    void *sb = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sb);
+    int rc = zmq_bind (sb, addr_);
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx_, ZMQ_PAIR);
+    assert (sc);
+    rc = zmq_connect (sc, addr_);
+    assert (rc == 0);
+
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, worker, sc);
+    assert (rc == 0);
+
+    for (int i = 0; i != ROUNDTRIPS; i++) {
+        rc = zmq_send (sb, &i, 4, 0);
+        assert (rc == 4);
+        int val;
+        rc = zmq_recv (sb, &val, sizeof (val), 0);
+        assert (rc == 4);
+        assert (val == i);
+    }
+
+    rc = pthread_join (thread, NULL);
+    assert (rc == 0);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    int spin = zmq_ctx_get (ctx, ZMQ_MAILBOX_SPIN);
+    assert (spin == ZMQ_MAILBOX_SPIN_DFLT);
+    int rc = zmq_ctx_set (ctx, ZMQ_MAILBOX_SPIN, -1);
+    assert (rc == -1 && errno == EINVAL);
+
+    //  A short spin makes the sockets go to sleep every now and then, a long
+    //  one keeps them spinning most of the time.
+    rc = zmq_ctx_set (ctx, ZMQ_MAILBOX_SPIN, 1000);
+    assert (rc == 0);
+    spin = zmq_ctx_get (ctx, ZMQ_MAILBOX_SPIN);
+    assert (spin == 1000);
+    pingpong (ctx, "inproc://short");
+
+    rc = zmq_ctx_set (ctx, ZMQ_MAILBOX_SPIN, 10000000);
+    assert (rc == 0);
+    pingpong (ctx, "inproc://long");
+
+    //  A receive timeout is still honoured while spinning.
+    void *s = zmq_socket (ctx, ZMQ_PULL);
+    assert (s);
+    int timeout = 50;
+    rc = zmq_setsockopt (s, ZMQ_RCVTIMEO, &timeout, sizeof (timeout));
+    assert (rc == 0);
+    char buf [8];
+    rc = zmq_recv (s, buf, sizeof (buf), 0);
+    assert (rc == -1 && errno == EAGAIN);
+    rc = zmq_close (s);
+    assert (rc == 0);
+
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
@@ -0,0 +1,104 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+int main (void)
+{
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_POOL) == 0);
+    int rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_POOL) == 1);
+
+    //  Messages are allocated by the I/O thread and released by this one,
+    //  so the blocks make a round trip through the remote free lists.
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    rc = zmq_bind (sb, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+
+    char content [200];
+    for (int i = 0; i != (int) sizeof (content); i++)
+        content [i] = (char) i;
+
+    for (int i = 0; i != 1000; i++) {
+        size_t size = 30 + i % 170;
+        rc = zmq_send (sc, content, size, 0);
+        assert (rc == (int) size);
+        char buf [200];
+        rc = zmq_recv (sb, buf, sizeof (buf), 0);
+        assert (rc == (int) size);
+        assert (memcmp (buf, content, size) == 0);
+    }
+
+    //  Messages allocated and released by the same thread.
+    for (int i = 0; i != 1000; i++) {
+        zmq_msg_t msg;
+        rc = zmq_msg_init_size (&msg, 100);
+        assert (rc == 0);
+        memset (zmq_msg_data (&msg), 'x', 100);
+        rc = zmq_msg_close (&msg);
+        assert (rc == 0);
+    }
+
+    int hits = zmq_ctx_get (ctx, ZMQ_MSG_POOL_HITS);
+    assert (hits > 0);
+    int misses = zmq_ctx_get (ctx, ZMQ_MSG_POOL_MISSES);
+    assert (misses > 0);
+    assert (hits > misses);
+
+    rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 0);
+    assert (rc == 0);
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_POOL) == 0);
+
+    //  Blocks allocated while the pool was enabled can be released after
+    //  it was disabled.
+    zmq_msg_t msg;
+    rc = zmq_msg_init_size (&msg, 100);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 1);
+    assert (rc == 0);
+    zmq_msg_t msg2;
+    rc = zmq_msg_init_size (&msg2, 100);
+    assert (rc == 0);
+    rc = zmq_ctx_set (ctx, ZMQ_MSG_POOL, 0);
+    assert (rc == 0);
+    rc = zmq_msg_close (&msg);
+    assert (rc == 0);
+    rc = zmq_msg_close (&msg2);
+    assert (rc == 0);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
@@ -0,0 +1,187 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <unistd.h>
+#include "testutil.hpp"
+
+int main (void)
+{
+    fprintf (stderr, "test_poller running...\n");
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+    void *a = zmq_socket (ctx, ZMQ_PAIR);
+    assert (a);
+    int rc = zmq_bind (a, "inproc://poller");
+    assert (rc == 0);
+    void *b = zmq_socket (ctx, ZMQ_PAIR);
+    assert (b);
+    rc = zmq_connect (b, "inproc://poller");
+    assert (rc == 0);
+
+    void *poller = zmq_poller_new ();
+    assert (poller);
+    int tag_a;
+    rc = zmq_poller_add (poller, a, &tag_a, ZMQ_POLLIN);
+    assert (rc == 0);
+    rc = zmq_poller_add (poller, a, NULL, ZMQ_POLLIN);
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Nothing to report yet.
+    zmq_poller_event_t events [4];
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == -1 && errno == EAGAIN);
+    rc = zmq_poller_wait_all (poller, events, 4, 50);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  A message wakes the poller up.
+    rc = zmq_send (b, "A", 1, 0);
+    assert (rc == 1);
+    rc = zmq_poller_wait_all (poller, events, 4, -1);
+    assert (rc == 1);
+    assert (events [0].socket == a && events [0].user_data == &tag_a);
+    assert (events [0].events == ZMQ_POLLIN);
+
+    //  Messages left unread are reported again.
+    rc = zmq_send (b, "B", 1, 0);
+    assert (rc == 1);
+    char buf [8];
+    rc = zmq_recv (a, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'A');
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == 1 && events [0].socket == a);
+    rc = zmq_recv (a, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'B');
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  The socket is reported even if the application has already processed
+    //  the notification about the new message itself.
+    rc = zmq_send (b, "E", 1, 0);
+    assert (rc == 1);
+    int zmq_events;
+    size_t zmq_events_size = sizeof (zmq_events);
+    rc = zmq_getsockopt (a, ZMQ_EVENTS, &zmq_events, &zmq_events_size);
+    assert (rc == 0 && zmq_events & ZMQ_POLLIN);
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == 1 && events [0].socket == a);
+    rc = zmq_recv (a, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'E');
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  Only the requested events are reported.
+    rc = zmq_poller_add (poller, b, NULL, ZMQ_POLLOUT);
+    assert (rc == 0);
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == 1 && events [0].socket == b);
+    assert (events [0].events == ZMQ_POLLOUT);
+    rc = zmq_poller_modify (poller, b, 0);
+    assert (rc == 0);
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  Raw file descriptors can be polled along with the sockets.
+    int fds [2];
+    rc = pipe (fds);
+    assert (rc == 0);
+    int tag_fd;
+    rc = zmq_poller_add_fd (poller, fds [0], &tag_fd, ZMQ_POLLIN);
+    assert (rc == 0);
+    rc = write (fds [1], "C", 1);
+    assert (rc == 1);
+    rc = zmq_send (b, "D", 1, 0);
+    assert (rc == 1);
+    rc = zmq_poller_wait_all (poller, events, 4, -1);
+    if (rc == 1) {
+        int rc2 = zmq_poller_wait_all (poller, events + 1, 3, -1);
+        assert (rc2 >= 1);
+        rc += rc2;
+    }
+    assert (rc == 2);
+    bool got_fd = false;
+    bool got_socket = false;
+    for (int i = 0; i != rc; i++) {
+        if (events [i].socket == NULL) {
+            assert (events [i].fd == fds [0]);
+            assert (events [i].user_data == &tag_fd);
+            got_fd = true;
+        }
+        else {
+            assert (events [i].socket == a);
+            got_socket = true;
+        }
+    }
+    assert (got_fd && got_socket);
+
+    //  No more events than requested are returned.
+    rc = zmq_poller_wait_all (poller, events, 1, 0);
+    assert (rc == 1);
+
+    rc = zmq_poller_remove_fd (poller, fds [0]);
+    assert (rc == 0);
+    rc = zmq_poller_remove_fd (poller, fds [0]);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_poller_remove (poller, a);
+    assert (rc == 0);
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  A hung up file descriptor is reported as an error, even though
+    //  only ZMQ_POLLIN was requested.
+    int hup [2];
+    rc = pipe (hup);
+    assert (rc == 0);
+    close (hup [1]);
+    rc = zmq_poller_add_fd (poller, hup [0], NULL, ZMQ_POLLIN);
+    assert (rc == 0);
+    rc = zmq_poller_wait_all (poller, events, 4, 1000);
+    assert (rc == 1);
+    assert (events [0].fd == hup [0]);
+    assert (events [0].events & ZMQ_POLLERR);
+    rc = zmq_poller_remove_fd (poller, hup [0]);
+    assert (rc == 0);
+    close (hup [0]);
+
+    //  Closing a socket removes it from the poller.
+    void *c = zmq_socket (ctx, ZMQ_PAIR);
+    assert (c);
+    rc = zmq_poller_add (poller, c, NULL, ZMQ_POLLIN | ZMQ_POLLOUT);
+    assert (rc == 0);
+    rc = zmq_close (c);
+    assert (rc == 0);
+    rc = zmq_poller_wait_all (poller, events, 4, 0);
+    assert (rc == -1 && errno == EAGAIN);
+
+    rc = zmq_poller_destroy (&poller);
+    assert (rc == 0 && poller == NULL);
+    rc = zmq_poller_destroy (&poller);
+    assert (rc == -1 && errno == EFAULT);
+
+    close (fds [0]);
+    close (fds [1]);
+    rc = zmq_close (a);
+    assert (rc == 0);
+    rc = zmq_close (b);
+    assert (rc == 0);
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
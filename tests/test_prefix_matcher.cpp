@@ -0,0 +1,166 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include "../include/zmq_utils.h"
+#include "testutil.hpp"
+
+//  The library does not export its internals, so the trie and the matcher
+//  are compiled in.
+#include "../src/trie.cpp"
+#include "../src/prefix_matcher.cpp"
+#include "../src/err.cpp"
+
+static unsigned long random_value (unsigned long *seed_)
+{
+    *seed_ = *seed_ * 1103515245 + 12345;
+    return (*seed_ >> 16) & 0x7fff;
+}
+
+//  Random topic of the given length, drawn from a small alphabet so that
+//  messages match the subscriptions reasonably often.
+static void make_topic (unsigned char *buf_, size_t size_,
+    unsigned long *seed_)
+{
+    for (size_t i = 0; i != size_; i++)
+        buf_ [i] = "ab\0\xff" [random_value (seed_) % 4];
+}
+
+//  Adds and removes random subscriptions of the given lengths to both the
+//  trie and the matcher and checks they agree on random messages.
+static void cross_check (const size_t *lengths_, size_t lengths_count_)
+{
+    unsigned long seed = 1;
+    zmq::trie_t trie;
+    zmq::prefix_matcher_t matcher;
+    unsigned char topic [32];
+
+    for (int i = 0; i != 20000; i++) {
+        size_t size = lengths_ [random_value (&seed) % lengths_count_];
+        make_topic (topic, size, &seed);
+        if (random_value (&seed) % 3) {
+            if (trie.add (topic, size))
+                matcher.add (topic, size);
+        }
+        else {
+            if (trie.rm (topic, size))
+                matcher.rm (topic, size);
+        }
+
+        size = random_value (&seed) % 24;
+        make_topic (topic, size, &seed);
+        assert (matcher.check (topic, size) == trie.check (topic, size));
+    }
+}
+
+static void check_sub (void *sub_, const char *topic_)
+{
+    char buf [32];
+    int rc = zmq_recv (sub_, buf, sizeof (buf), 0);
+    assert (rc == (int) strlen (topic_));
+    assert (memcmp (buf, topic_, rc) == 0);
+}
+
+int main (void)
+{
+    fprintf (stderr, "test_prefix_matcher running...\n");
+
+    //  The matcher takes over from the trie once there are enough short
+    //  subscriptions of few lengths.
+    zmq::prefix_matcher_t matcher;
+    assert (!matcher.usable ());
+    for (int i = 0; i != 256; i++) {
+        unsigned char topic [4] = {'t', 'o', 'p', (unsigned char) i};
+        matcher.add (topic, sizeof (topic));
+    }
+    assert (matcher.usable ());
+    unsigned char topic [32];
+    memset (topic, 'x', sizeof (topic));
+    matcher.add (topic, sizeof (topic));
+    assert (!matcher.usable ());
+    matcher.rm (topic, sizeof (topic));
+    assert (matcher.usable ());
+    for (int i = 5; i != 9; i++)
+        matcher.add (topic, i);
+    assert (!matcher.usable ());
+    matcher.rm (topic, 5);
+    assert (matcher.usable ());
+
+    //  Cross-check the matcher against the trie, including the empty
+    //  subscription and the longest prefixes the matcher handles.
+    size_t fixed [] = {3};
+    cross_check (fixed, 1);
+    size_t mixed [] = {1, 5, 8, 16};
+    cross_check (mixed, 4);
+    size_t with_empty [] = {0, 2, 9, 15};
+    cross_check (with_empty, 4);
+
+    //  SUB socket with many fixed-length subscriptions filters the messages
+    //  the same way as with a few.
+    void *ctx = zmq_init (1);
+    assert (ctx);
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    int rc = zmq_bind (pub, "inproc://prefix_matcher");
+    assert (rc == 0);
+    void *sub = zmq_socket (ctx, ZMQ_SUB);
+    assert (sub);
+    for (int i = 0; i != 1000; i++) {
+        char prefix [8];
+        sprintf (prefix, "T%03d", i);
+        rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, prefix, 4);
+        assert (rc == 0);
+    }
+    rc = zmq_connect (sub, "inproc://prefix_matcher");
+    assert (rc == 0);
+
+    //  Give the subscriptions time to get to the publisher.
+    zmq_sleep (1);
+
+    rc = zmq_send (pub, "t100", 4, 0);
+    assert (rc == 4);
+    rc = zmq_send (pub, "T042", 4, 0);
+    assert (rc == 4);
+    rc = zmq_send (pub, "T04", 3, 0);
+    assert (rc == 3);
+    rc = zmq_send (pub, "T999 quote", 10, 0);
+    assert (rc == 10);
+    rc = zmq_send (pub, "X000", 4, 0);
+    assert (rc == 4);
+    check_sub (sub, "T042");
+    check_sub (sub, "T999 quote");
+
+    //  Once unsubscribed, the topic is not delivered anymore.
+    rc = zmq_setsockopt (sub, ZMQ_UNSUBSCRIBE, "T042", 4);
+    assert (rc == 0);
+    rc = zmq_send (pub, "T042", 4, 0);
+    assert (rc == 4);
+    rc = zmq_send (pub, "T000", 4, 0);
+    assert (rc == 4);
+    check_sub (sub, "T000");
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
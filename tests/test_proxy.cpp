@@ -0,0 +1,278 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <pthread.h>
+#include <stdlib.h>
+#include "testutil.hpp"
+#include "../src/stdint.hpp"
+
+static void *frontend;
+static void *backend;
+
+static void *proxy_thread (void *)
+{
+    int rc = zmq_proxy (frontend, backend, NULL);
+    assert (rc == -1 && errno == ETERM);
+    rc = zmq_close (frontend);
+    assert (rc == 0);
+    rc = zmq_close (backend);
+    assert (rc == 0);
+    return NULL;
+}
+
+static void *control;
+
+static void *steerable_proxy_thread (void *)
+{
+    int rc = zmq_proxy_steerable (frontend, backend, NULL,
+        control);
+    assert (rc == 0);
+    rc = zmq_close (frontend);
+    assert (rc == 0);
+    rc = zmq_close (backend);
+    assert (rc == 0);
+    rc = zmq_close (control);
+    assert (rc == 0);
+    return NULL;
+}
+
+static void set_int (void *s_, int option_, int value_)
+{
+    int rc = zmq_setsockopt (s_, option_, &value_, sizeof (value_));
+    assert (rc == 0);
+}
+
+static void test_backpressure ()
+{
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    frontend = zmq_socket (ctx, ZMQ_ROUTER);
+    assert (frontend);
+    set_int (frontend, ZMQ_LINGER, 0);
+    int rc = zmq_bind (frontend, "inproc://frontend");
+    assert (rc == 0);
+
+    backend = zmq_socket (ctx, ZMQ_DEALER);
+    assert (backend);
+    set_int (backend, ZMQ_LINGER, 0);
+    set_int (backend, ZMQ_SNDHWM, 1);
+    rc = zmq_bind (backend, "inproc://backend");
+    assert (rc == 0);
+
+    void *client = zmq_socket (ctx, ZMQ_DEALER);
+    assert (client);
+    set_int (client, ZMQ_LINGER, 0);
+    rc = zmq_setsockopt (client, ZMQ_IDENTITY, "C", 1);
+    assert (rc == 0);
+    rc = zmq_connect (client, "inproc://frontend");
+    assert (rc == 0);
+
+    void *worker = zmq_socket (ctx, ZMQ_DEALER);
+    assert (worker);
+    set_int (worker, ZMQ_LINGER, 0);
+    set_int (worker, ZMQ_RCVHWM, 1);
+    rc = zmq_connect (worker, "inproc://backend");
+    assert (rc == 0);
+
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, proxy_thread, NULL);
+    assert (rc == 0);
+
+    //  Send more requests than the worker is able to queue. The proxy
+    //  gets stuck with the requests that don't fit.
+    char buf [32];
+    for (int i = 0; i != 100; i++) {
+        rc = zmq_send (client, "part", 4, ZMQ_SNDMORE);
+        assert (rc == 4);
+        sprintf (buf, "%d", i);
+        rc = zmq_send (client, buf, strlen (buf), 0);
+        assert (rc == (int) strlen (buf));
+    }
+
+    //  Replies still get through, although requests are blocked.
+    rc = zmq_send (worker, "C", 1, ZMQ_SNDMORE);
+    assert (rc == 1);
+    rc = zmq_send (worker, "reply", 5, 0);
+    assert (rc == 5);
+    rc = zmq_recv (client, buf, sizeof (buf), 0);
+    assert (rc == 5 && memcmp (buf, "reply", 5) == 0);
+
+    //  Once the worker starts reading, all the requests arrive whole and
+    //  in order.
+    for (int i = 0; i != 100; i++) {
+        rc = zmq_recv (worker, buf, sizeof (buf), 0);
+        assert (rc == 1 && buf [0] == 'C');
+        rc = zmq_recv (worker, buf, sizeof (buf), 0);
+        assert (rc == 4 && memcmp (buf, "part", 4) == 0);
+        rc = zmq_recv (worker, buf, sizeof (buf) - 1, 0);
+        assert (rc > 0);
+        buf [rc] = 0;
+        assert (atoi (buf) == i);
+        int more;
+        size_t more_size = sizeof (more);
+        rc = zmq_getsockopt (worker, ZMQ_RCVMORE, &more, &more_size);
+        assert (rc == 0 && !more);
+    }
+
+    rc = zmq_close (client);
+    assert (rc == 0);
+    rc = zmq_close (worker);
+    assert (rc == 0);
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    rc = pthread_join (thread, NULL);
+    assert (rc == 0);
+}
+
+static void send_command (void *s_, const char *command_)
+{
+    int rc = zmq_send (s_, command_, strlen (command_), 0);
+    assert (rc == (int) strlen (command_));
+    char reply [1];
+    rc = zmq_recv (s_, reply, sizeof (reply), 0);
+    assert (rc == 0);
+}
+
+//  Retrieves the frames and bytes passed and the microseconds spent stalled
+//  for both directions.
+static void get_statistics (void *s_, uint64_t *values_)
+{
+    int rc = zmq_send (s_, "STATISTICS", 10, 0);
+    assert (rc == 10);
+    for (int i = 0; i != 6; i++) {
+        rc = zmq_recv (s_, &values_ [i], sizeof (uint64_t), 0);
+        assert (rc == sizeof (uint64_t));
+        int more;
+        size_t more_size = sizeof (more);
+        rc = zmq_getsockopt (s_, ZMQ_RCVMORE, &more, &more_size);
+        assert (rc == 0 && more == (i != 5));
+    }
+}
+
+static void test_control ()
+{
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    frontend = zmq_socket (ctx, ZMQ_PULL);
+    assert (frontend);
+    int rc = zmq_bind (frontend, "inproc://frontend");
+    assert (rc == 0);
+    backend = zmq_socket (ctx, ZMQ_PUSH);
+    assert (backend);
+    set_int (backend, ZMQ_LINGER, 0);
+    set_int (backend, ZMQ_SNDHWM, 1);
+    rc = zmq_bind (backend, "inproc://backend");
+    assert (rc == 0);
+    control = zmq_socket (ctx, ZMQ_REP);
+    assert (control);
+    rc = zmq_bind (control, "inproc://control");
+    assert (rc == 0);
+
+    void *producer = zmq_socket (ctx, ZMQ_PUSH);
+    assert (producer);
+    rc = zmq_connect (producer, "inproc://frontend");
+    assert (rc == 0);
+    void *consumer = zmq_socket (ctx, ZMQ_PULL);
+    assert (consumer);
+    set_int (consumer, ZMQ_RCVHWM, 1);
+    rc = zmq_connect (consumer, "inproc://backend");
+    assert (rc == 0);
+    void *steer = zmq_socket (ctx, ZMQ_REQ);
+    assert (steer);
+    rc = zmq_connect (steer, "inproc://control");
+    assert (rc == 0);
+
+    pthread_t thread;
+    rc = pthread_create (&thread, NULL, steerable_proxy_thread, NULL);
+    assert (rc == 0);
+
+    //  Multipart messages are counted frame by frame.
+    char buf [32];
+    for (int i = 0; i != 5; i++) {
+        rc = zmq_send (producer, "A", 1, ZMQ_SNDMORE);
+        assert (rc == 1);
+        rc = zmq_send (producer, "BCDE", 4, 0);
+        assert (rc == 4);
+        rc = zmq_recv (consumer, buf, sizeof (buf), 0);
+        assert (rc == 1);
+        rc = zmq_recv (consumer, buf, sizeof (buf), 0);
+        assert (rc == 4);
+    }
+    uint64_t stats [6];
+    get_statistics (steer, stats);
+
+    //  The proxy may stall briefly on the consumer's tiny pipe until the
+    //  consumer's reads are reported back, so the stall time is not zero
+    //  for sure.
+    assert (stats [0] == 10 && stats [1] == 25);
+    assert (stats [3] == 0 && stats [4] == 0 && stats [5] == 0);
+
+    //  Nothing is passed while the proxy is paused.
+    send_command (steer, "PAUSE");
+    rc = zmq_send (producer, "F", 1, 0);
+    assert (rc == 1);
+    zmq_pollitem_t item = {consumer, 0, ZMQ_POLLIN, 0};
+    rc = zmq_poll (&item, 1, 100);
+    assert (rc == 0);
+    send_command (steer, "RESUME");
+    rc = zmq_recv (consumer, buf, sizeof (buf), 0);
+    assert (rc == 1 && buf [0] == 'F');
+
+    //  Time spent waiting for the consumer is accounted for, including the
+    //  wait that is still going on.
+    for (int i = 0; i != 10; i++) {
+        rc = zmq_send (producer, "G", 1, 0);
+        assert (rc == 1);
+    }
+    rc = zmq_poll (NULL, 0, 100);
+    assert (rc == 0);
+    get_statistics (steer, stats);
+    assert (stats [0] < 21 && stats [2] >= 50000);
+    for (int i = 0; i != 10; i++) {
+        rc = zmq_recv (consumer, buf, sizeof (buf), 0);
+        assert (rc == 1 && buf [0] == 'G');
+    }
+    get_statistics (steer, stats);
+    assert (stats [0] == 21 && stats [1] == 36 && stats [2] >= 50000);
+
+    send_command (steer, "TERMINATE");
+    rc = pthread_join (thread, NULL);
+    assert (rc == 0);
+
+    rc = zmq_close (producer);
+    assert (rc == 0);
+    rc = zmq_close (consumer);
+    assert (rc == 0);
+    rc = zmq_close (steer);
+    assert (rc == 0);
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    fprintf (stderr, "test_proxy running...\n");
+
+    test_backpressure ();
+    test_control ();
+
+    return 0 ;
+}
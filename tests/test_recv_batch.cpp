@@ -0,0 +1,112 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+int main (void)
+{
+    void *ctx = zmq_init (0);
+    assert (ctx);
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int rc = zmq_bind (sb, "inproc://a");
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_connect (sc, "inproc://a");
+    assert (rc == 0);
+
+    zmq_msg_t msgs [4];
+    for (int i = 0; i != 4; i++) {
+        rc = zmq_msg_init (&msgs [i]);
+        assert (rc == 0);
+    }
+
+    //  Invalid arguments are rejected.
+    rc = zmq_recv_batch (sb, NULL, 4, 0);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_recv_batch (sb, msgs, 0, 0);
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Nothing to receive yet.
+    rc = zmq_recv_batch (sb, msgs, 4, ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  Send a single-part message followed by a 2-part message.
+    rc = zmq_send (sc, "A", 1, 0);
+    assert (rc == 1);
+    rc = zmq_send (sc, "BB", 2, ZMQ_SNDMORE);
+    assert (rc == 2);
+    rc = zmq_send (sc, "CCC", 3, 0);
+    assert (rc == 3);
+
+    //  All three parts are available and are received in one go. Running
+    //  out of parts doesn't touch errno.
+    errno = 0;
+    rc = zmq_recv_batch (sb, msgs, 4, 0);
+    assert (rc == 3);
+    assert (errno == 0);
+    assert (zmq_msg_size (&msgs [0]) == 1);
+    assert (memcmp (zmq_msg_data (&msgs [0]), "A", 1) == 0);
+    assert (zmq_msg_more (&msgs [0]) == 0);
+    assert (zmq_msg_size (&msgs [1]) == 2);
+    assert (memcmp (zmq_msg_data (&msgs [1]), "BB", 2) == 0);
+    assert (zmq_msg_more (&msgs [1]) == 1);
+    assert (zmq_msg_size (&msgs [2]) == 3);
+    assert (memcmp (zmq_msg_data (&msgs [2]), "CCC", 3) == 0);
+    assert (zmq_msg_more (&msgs [2]) == 0);
+
+    //  A batch smaller than the backlog leaves the rest in the socket and
+    //  ZMQ_RCVMORE reflects the last part stored.
+    rc = zmq_send (sc, "D", 1, ZMQ_SNDMORE);
+    assert (rc == 1);
+    rc = zmq_send (sc, "E", 1, 0);
+    assert (rc == 1);
+    rc = zmq_recv_batch (sb, msgs, 1, 0);
+    assert (rc == 1);
+    assert (memcmp (zmq_msg_data (&msgs [0]), "D", 1) == 0);
+    int more;
+    size_t more_size = sizeof (more);
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0);
+    assert (more == 1);
+    rc = zmq_recv_batch (sb, msgs, 4, 0);
+    assert (rc == 1);
+    assert (memcmp (zmq_msg_data (&msgs [0]), "E", 1) == 0);
+    rc = zmq_getsockopt (sb, ZMQ_RCVMORE, &more, &more_size);
+    assert (rc == 0);
+    assert (more == 0);
+
+    for (int i = 0; i != 4; i++) {
+        rc = zmq_msg_close (&msgs [i]);
+        assert (rc == 0);
+    }
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
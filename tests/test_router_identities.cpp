@@ -0,0 +1,162 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include "testutil.hpp"
+
+const int dealer_count = 10;
+const int peers_per_dealer = 100;
+
+//  Identities of various lengths, some of them too long to be stored
+//  inline by std::basic_string.
+static size_t make_identity (char *buf_, int dealer_, int peer_)
+{
+    int len = sprintf (buf_, "peer-%d-%d-", dealer_, peer_);
+    int pad = peer_ % 40;
+    memset (buf_ + len, 'x', pad);
+    return len + pad;
+}
+
+//  Sends a message to the peer, its body being the peer's identity. Returns
+//  false if the peer is unknown.
+static bool route (void *router_, const char *identity_, size_t size_)
+{
+    int rc = zmq_send (router_, identity_, size_, ZMQ_SNDMORE | ZMQ_DONTWAIT);
+    if (rc == -1) {
+        assert (errno == EHOSTUNREACH);
+        return false;
+    }
+    assert (rc == (int) size_);
+    rc = zmq_send (router_, identity_, size_, 0);
+    assert (rc == (int) size_);
+    return true;
+}
+
+//  Routes the message, waiting till the ROUTER learns about the peer.
+static void route_wait (void *router_, const char *identity_, size_t size_)
+{
+    while (!route (router_, identity_, size_)) {
+        int events;
+        size_t events_size = sizeof (events);
+        int rc = zmq_getsockopt (router_, ZMQ_EVENTS, &events, &events_size);
+        assert (rc == 0);
+    }
+}
+
+static void check_recv (void *dealer_, const char *identity_, size_t size_)
+{
+    char buf [64];
+    int rc = zmq_recv (dealer_, buf, sizeof (buf), 0);
+    assert (rc == (int) size_);
+    assert (memcmp (buf, identity_, size_) == 0);
+}
+
+int main (void)
+{
+    fprintf (stderr, "test_router_identities running...\n");
+
+    void *ctx = zmq_init (1);
+    assert (ctx);
+
+    void *router = zmq_socket (ctx, ZMQ_ROUTER);
+    assert (router);
+    int mandatory = 1;
+    int rc = zmq_setsockopt (router, ZMQ_ROUTER_MANDATORY, &mandatory,
+        sizeof (mandatory));
+    assert (rc == 0);
+    rc = zmq_bind (router, "inproc://router");
+    assert (rc == 0);
+
+    //  Each DEALER connects several times, using a different identity each
+    //  time, so the ROUTER sees many peers.
+    void *dealers [dealer_count];
+    char identity [64];
+    size_t size;
+    for (int d = 0; d != dealer_count; d++) {
+        dealers [d] = zmq_socket (ctx, ZMQ_DEALER);
+        assert (dealers [d]);
+        for (int p = 0; p != peers_per_dealer; p++) {
+            size = make_identity (identity, d, p);
+            rc = zmq_setsockopt (dealers [d], ZMQ_IDENTITY, identity, size);
+            assert (rc == 0);
+            rc = zmq_connect (dealers [d], "inproc://router");
+            assert (rc == 0);
+        }
+    }
+
+    //  Every peer gets the messages addressed to it.
+    for (int d = 0; d != dealer_count; d++)
+        for (int p = 0; p != peers_per_dealer; p++) {
+            size = make_identity (identity, d, p);
+            route_wait (router, identity, size);
+        }
+    for (int d = 0; d != dealer_count; d++)
+        for (int p = 0; p != peers_per_dealer; p++) {
+            char buf [64];
+            rc = zmq_recv (dealers [d], buf, sizeof (buf), 0);
+            assert (rc > 0);
+            char prefix [16];
+            int len = sprintf (prefix, "peer-%d-", d);
+            assert (memcmp (buf, prefix, len) == 0);
+        }
+
+    //  A peer using an identity that is taken already is ignored.
+    size = make_identity (identity, 1, 0);
+    rc = zmq_setsockopt (dealers [0], ZMQ_IDENTITY, identity, size);
+    assert (rc == 0);
+    rc = zmq_connect (dealers [0], "inproc://router");
+    assert (rc == 0);
+    route_wait (router, identity, size);
+    check_recv (dealers [1], identity, size);
+
+    //  Once the peers disconnect, they are forgotten. The others stay.
+    for (int d = 0; d < dealer_count; d += 2) {
+        rc = zmq_close (dealers [d]);
+        assert (rc == 0);
+    }
+    for (int d = 0; d < dealer_count; d += 2)
+        for (int p = 0; p != peers_per_dealer; p++) {
+            size = make_identity (identity, d, p);
+            while (route (router, identity, size)) {
+                int events;
+                size_t events_size = sizeof (events);
+                rc = zmq_getsockopt (router, ZMQ_EVENTS, &events,
+                    &events_size);
+                assert (rc == 0);
+            }
+        }
+    for (int d = 1; d < dealer_count; d += 2)
+        for (int p = 0; p != peers_per_dealer; p++) {
+            size = make_identity (identity, d, p);
+            bool ok = route (router, identity, size);
+            assert (ok);
+            check_recv (dealers [d], identity, size);
+        }
+
+    for (int d = 1; d < dealer_count; d += 2) {
+        rc = zmq_close (dealers [d]);
+        assert (rc == 0);
+    }
+    rc = zmq_close (router);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+
+    return 0 ;
+}
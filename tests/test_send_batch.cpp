@@ -0,0 +1,161 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include <string.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+static void fill (zmq_msg_t *msgs_, int count_)
+{
+    for (int i = 0; i != count_; i++) {
+        int rc = zmq_msg_init_size (&msgs_ [i], sizeof (int));
+        assert (rc == 0);
+        memcpy (zmq_msg_data (&msgs_ [i]), &i, sizeof (int));
+    }
+}
+
+static void close_all (zmq_msg_t *msgs_, int count_)
+{
+    for (int i = 0; i != count_; i++) {
+        int rc = zmq_msg_close (&msgs_ [i]);
+        assert (rc == 0);
+    }
+}
+
+static void recv_in_order (void *s_, int count_)
+{
+    for (int i = 0; i != count_; i++) {
+        int val;
+        int rc = zmq_recv (s_, &val, sizeof (val), 0);
+        assert (rc == sizeof (int));
+        assert (val == i);
+        int more;
+        size_t more_size = sizeof (more);
+        rc = zmq_getsockopt (s_, ZMQ_RCVMORE, &more, &more_size);
+        assert (rc == 0);
+        assert (more == 0);
+    }
+}
+
+int main (void)
+{
+    void *ctx = zmq_init (0);
+    assert (ctx);
+
+    zmq_msg_t msgs [100];
+
+    //  PUSH socket with no peers cannot send anything.
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (push);
+    fill (msgs, 100);
+    int rc = zmq_send_batch (push, msgs, 100, ZMQ_DONTWAIT);
+    assert (rc == -1 && errno == EAGAIN);
+
+    //  Invalid arguments are rejected.
+    rc = zmq_send_batch (push, NULL, 100, 0);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_send_batch (push, msgs, 0, 0);
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_send_batch (push, msgs, 100, ZMQ_SNDMORE);
+    assert (rc == -1 && errno == EINVAL);
+
+    //  Once connected, the whole batch is delivered in order as separate
+    //  messages.
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_bind (pull, "inproc://push");
+    assert (rc == 0);
+    rc = zmq_connect (push, "inproc://push");
+    assert (rc == 0);
+    rc = zmq_send_batch (push, msgs, 100, 0);
+    assert (rc == 100);
+    recv_in_order (pull, 100);
+    close_all (msgs, 100);
+
+    //  With a high watermark in the way only part of the batch gets sent
+    //  and the rest stays with the caller.
+    void *hwm_push = zmq_socket (ctx, ZMQ_PUSH);
+    assert (hwm_push);
+    int hwm = 10;
+    rc = zmq_setsockopt (hwm_push, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    void *hwm_pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (hwm_pull);
+    rc = zmq_setsockopt (hwm_pull, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_bind (hwm_pull, "inproc://hwm");
+    assert (rc == 0);
+    rc = zmq_connect (hwm_push, "inproc://hwm");
+    assert (rc == 0);
+    fill (msgs, 100);
+    rc = zmq_send_batch (hwm_push, msgs, 100, ZMQ_DONTWAIT);
+    assert (rc > 0 && rc < 100);
+    int sent = rc;
+    assert (zmq_msg_size (&msgs [0]) == 0);
+    assert (zmq_msg_size (&msgs [sent]) == sizeof (int));
+    recv_in_order (hwm_pull, sent);
+    close_all (msgs, 100);
+
+    //  PUB socket delivers the batch to each subscriber.
+    void *pub = zmq_socket (ctx, ZMQ_PUB);
+    assert (pub);
+    rc = zmq_bind (pub, "inproc://pub");
+    assert (rc == 0);
+    void *subs [3];
+    for (int i = 0; i != 3; i++) {
+        subs [i] = zmq_socket (ctx, ZMQ_SUB);
+        assert (subs [i]);
+        rc = zmq_setsockopt (subs [i], ZMQ_SUBSCRIBE, "", 0);
+        assert (rc == 0);
+        rc = zmq_connect (subs [i], "inproc://pub");
+        assert (rc == 0);
+    }
+
+    //  Give the subscriptions time to reach the publisher.
+    zmq_pollitem_t items [] = {{pub, 0, ZMQ_POLLIN, 0}};
+    rc = zmq_poll (items, 1, 100);
+    assert (rc == 0);
+
+    fill (msgs, 100);
+    rc = zmq_send_batch (pub, msgs, 100, 0);
+    assert (rc == 100);
+    for (int i = 0; i != 3; i++)
+        recv_in_order (subs [i], 100);
+    close_all (msgs, 100);
+
+    for (int i = 0; i != 3; i++) {
+        rc = zmq_close (subs [i]);
+        assert (rc == 0);
+    }
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    rc = zmq_close (hwm_pull);
+    assert (rc == 0);
+    rc = zmq_close (hwm_push);
+    assert (rc == 0);
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+    rc = zmq_term (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
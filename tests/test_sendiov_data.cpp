@@ -0,0 +1,113 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include <string.h>
+#include <stdlib.h>
+#include <sys/uio.h>
+
+#undef NDEBUG
+#include <assert.h>
+
+static int released;
+
+static void release (void *data_, void *hint_)
+{
+    assert (hint_ == (void*) &released);
+    free (data_);
+    released++;
+}
+
+static void send_parts (void *s_, size_t count_)
+{
+    struct iovec iov [3];
+    const size_t sizes [3] = {5, 1000, 20000};
+    for (size_t i = 0; i != count_; i++) {
+        iov [i].iov_base = malloc (sizes [i]);
+        assert (iov [i].iov_base);
+        memset (iov [i].iov_base, 'a' + (int) i, sizes [i]);
+        iov [i].iov_len = sizes [i];
+    }
+    int rc = zmq_sendiov_data (s_, iov, count_, ZMQ_SNDMORE, release,
+        &released);
+    assert (rc == (int) sizes [count_ - 1]);
+}
+
+static void recv_parts (void *s_, size_t count_)
+{
+    const size_t sizes [3] = {5, 1000, 20000};
+    for (size_t i = 0; i != count_; i++) {
+        zmq_msg_t msg;
+        int rc = zmq_msg_init (&msg);
+        assert (rc == 0);
+        rc = zmq_msg_recv (&msg, s_, 0);
+        assert (rc == (int) sizes [i]);
+        for (size_t j = 0; j != sizes [i]; j++)
+            assert (((char*) zmq_msg_data (&msg)) [j] == 'a' + (int) i);
+        assert (zmq_msg_more (&msg) == (i != count_ - 1));
+        rc = zmq_msg_close (&msg);
+        assert (rc == 0);
+    }
+}
+
+int main (void)
+{
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *sb = zmq_socket (ctx, ZMQ_PULL);
+    assert (sb);
+    int rc = zmq_bind (sb, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+    void *sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    rc = zmq_connect (sc, "tcp://127.0.0.1:5560");
+    assert (rc == 0);
+
+    //  All the buffers are released once the message is received.
+    send_parts (sc, 3);
+    recv_parts (sb, 3);
+    send_parts (sc, 1);
+    recv_parts (sb, 1);
+
+    rc = zmq_close (sc);
+    assert (rc == 0);
+    rc = zmq_close (sb);
+    assert (rc == 0);
+    assert (released == 4);
+
+    //  If the message cannot be sent, the buffers are released anyway.
+    sc = zmq_socket (ctx, ZMQ_PUSH);
+    assert (sc);
+    struct iovec iov [2];
+    for (int i = 0; i != 2; i++) {
+        iov [i].iov_base = malloc (100);
+        assert (iov [i].iov_base);
+        iov [i].iov_len = 100;
+    }
+    rc = zmq_sendiov_data (sc, iov, 2, ZMQ_DONTWAIT, release, &released);
+    assert (rc == -1 && errno == EAGAIN);
+    assert (released == 6);
+    rc = zmq_close (sc);
+    assert (rc == 0);
+
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
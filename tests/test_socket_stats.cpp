@@ -0,0 +1,203 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "../include/zmq_utils.h"
+#include "../src/stdint.hpp"
+
+static void send_string (void *socket_, const char *data_, int flags_)
+{
+    int rc = zmq_send (socket_, data_, strlen (data_), flags_);
+    assert (rc == (int) strlen (data_));
+}
+
+static void get_stats (void *socket_, uint64_t *stats_)
+{
+    size_t size = ZMQ_STAT_COUNT * sizeof (uint64_t);
+    int rc = zmq_getsockopt (socket_, ZMQ_STATISTICS, stats_, &size);
+    assert (rc == 0);
+    assert (size == ZMQ_STAT_COUNT * sizeof (uint64_t));
+}
+
+static void test_traffic (void *ctx_)
+{
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    assert (push);
+    int rc = zmq_bind (push, "inproc://traffic");
+    assert (rc == 0);
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    assert (pull);
+    rc = zmq_connect (pull, "inproc://traffic");
+    assert (rc == 0);
+
+    //  A single-part message and a two-part one.
+    rc = zmq_send (push, "hello", 5, 0);
+    assert (rc == 5);
+    rc = zmq_send (push, "ab", 2, ZMQ_SNDMORE);
+    assert (rc == 2);
+    rc = zmq_send (push, "cde", 3, 0);
+    assert (rc == 3);
+
+    char buf [16];
+    for (int i = 0; i != 3; i++) {
+        rc = zmq_recv (pull, buf, sizeof (buf), 0);
+        assert (rc > 0);
+    }
+
+    uint64_t stats [ZMQ_STAT_COUNT];
+    get_stats (push, stats);
+    assert (stats [ZMQ_STAT_MSGS_OUT] == 2);
+    assert (stats [ZMQ_STAT_BYTES_OUT] == 10);
+    assert (stats [ZMQ_STAT_MSGS_IN] == 0);
+    assert (stats [ZMQ_STAT_BYTES_IN] == 0);
+    assert (stats [ZMQ_STAT_HWM_DROPS] == 0);
+    assert (stats [ZMQ_STAT_UNROUTABLE_DROPS] == 0);
+    get_stats (pull, stats);
+    assert (stats [ZMQ_STAT_MSGS_IN] == 2);
+    assert (stats [ZMQ_STAT_BYTES_IN] == 10);
+    assert (stats [ZMQ_STAT_MSGS_OUT] == 0);
+
+    //  A shorter buffer gets the leading counters only.
+    uint64_t two [2];
+    size_t size = sizeof (two);
+    rc = zmq_getsockopt (pull, ZMQ_STATISTICS, two, &size);
+    assert (rc == 0);
+    assert (size == sizeof (two));
+    assert (two [ZMQ_STAT_MSGS_IN] == 2);
+    assert (two [ZMQ_STAT_BYTES_IN] == 10);
+    size = 4;
+    rc = zmq_getsockopt (pull, ZMQ_STATISTICS, two, &size);
+    assert (rc == -1 && errno == EINVAL);
+
+    rc = zmq_close (pull);
+    assert (rc == 0);
+    rc = zmq_close (push);
+    assert (rc == 0);
+}
+
+static void test_hwm_drops (void *ctx_)
+{
+    int hwm = 1;
+    void *pub = zmq_socket (ctx_, ZMQ_XPUB);
+    assert (pub);
+    int rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://hwm");
+    assert (rc == 0);
+    void *sub = zmq_socket (ctx_, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    rc = zmq_connect (sub, "inproc://hwm");
+    assert (rc == 0);
+
+    //  Wait for the subscription to arrive.
+    char buf [16];
+    rc = zmq_recv (pub, buf, sizeof (buf), 0);
+    assert (rc == 1);
+
+    //  Nobody reads, so all but the first few messages are dropped.
+    const int count = 10;
+    for (int i = 0; i != count; i++) {
+        rc = zmq_send (pub, "x", 1, 0);
+        assert (rc == 1);
+    }
+    int received = 0;
+    while (zmq_recv (sub, buf, sizeof (buf), ZMQ_DONTWAIT) == 1)
+        received++;
+
+    uint64_t stats [ZMQ_STAT_COUNT];
+    get_stats (pub, stats);
+    assert (stats [ZMQ_STAT_MSGS_OUT] == (uint64_t) count);
+    assert (stats [ZMQ_STAT_HWM_DROPS] > 0);
+    assert (stats [ZMQ_STAT_HWM_DROPS] + received == (uint64_t) count);
+    assert (stats [ZMQ_STAT_UNROUTABLE_DROPS] == 0);
+    assert (stats [ZMQ_STAT_MSGS_IN] == 1);
+    get_stats (sub, stats);
+    assert (stats [ZMQ_STAT_MSGS_IN] == (uint64_t) received);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+}
+
+static void test_unroutable_drops (void *ctx_)
+{
+    void *router = zmq_socket (ctx_, ZMQ_ROUTER);
+    assert (router);
+
+    send_string (router, "nobody", ZMQ_SNDMORE);
+    send_string (router, "x", 0);
+    send_string (router, "nobody", ZMQ_SNDMORE);
+    send_string (router, "", ZMQ_SNDMORE);
+    send_string (router, "y", 0);
+
+    uint64_t stats [ZMQ_STAT_COUNT];
+    get_stats (router, stats);
+    assert (stats [ZMQ_STAT_UNROUTABLE_DROPS] == 2);
+    assert (stats [ZMQ_STAT_HWM_DROPS] == 0);
+    assert (stats [ZMQ_STAT_MSGS_OUT] == 2);
+
+    int rc = zmq_close (router);
+    assert (rc == 0);
+}
+
+static void test_reconnects (void *ctx_)
+{
+    void *dealer = zmq_socket (ctx_, ZMQ_DEALER);
+    assert (dealer);
+    int ivl = 10;
+    int rc = zmq_setsockopt (dealer, ZMQ_RECONNECT_IVL, &ivl, sizeof (ivl));
+    assert (rc == 0);
+
+    //  Nobody listens on the port, so the connecter keeps retrying.
+    rc = zmq_connect (dealer, "tcp://127.0.0.1:5562");
+    assert (rc == 0);
+    zmq_sleep (1);
+
+    uint64_t stats [ZMQ_STAT_COUNT];
+    get_stats (dealer, stats);
+    assert (stats [ZMQ_STAT_RECONNECTS] > 0);
+
+    int linger = 0;
+    rc = zmq_setsockopt (dealer, ZMQ_LINGER, &linger, sizeof (linger));
+    assert (rc == 0);
+    rc = zmq_close (dealer);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    fprintf (stderr, "test_socket_stats running...\n");
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    test_traffic (ctx);
+    test_hwm_drops (ctx);
+    test_unroutable_drops (ctx);
+    test_reconnects (ctx);
+
+    int rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
@@ -0,0 +1,156 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+
+static void publish (void *pub_, const char *topic_, const char *value_)
+{
+    int rc = zmq_send (pub_, topic_, strlen (topic_), ZMQ_SNDMORE);
+    assert (rc == (int) strlen (topic_));
+    rc = zmq_send (pub_, value_, strlen (value_), 0);
+    assert (rc == (int) strlen (value_));
+}
+
+static void expect (void *sub_, const char *topic_, const char *value_)
+{
+    char buf [64];
+    int rc = zmq_recv (sub_, buf, sizeof (buf), 0);
+    assert (rc == (int) strlen (topic_));
+    assert (memcmp (buf, topic_, rc) == 0);
+    int more;
+    size_t size = sizeof (more);
+    rc = zmq_getsockopt (sub_, ZMQ_RCVMORE, &more, &size);
+    assert (rc == 0 && more);
+    rc = zmq_recv (sub_, buf, sizeof (buf), 0);
+    assert (rc == (int) strlen (value_));
+    assert (memcmp (buf, value_, rc) == 0);
+}
+
+static void expect_nothing (void *sub_)
+{
+    zmq_pollitem_t item = {sub_, 0, ZMQ_POLLIN, 0};
+    int rc = zmq_poll (&item, 1, 100);
+    assert (rc == 0);
+}
+
+//  Connects a new subscriber and lets the publisher process its
+//  subscription.
+static void *subscribe (void *ctx_, void *pub_, const char *addr_,
+    const char *topic_)
+{
+    void *sub = zmq_socket (ctx_, ZMQ_SUB);
+    assert (sub);
+    int rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, topic_, strlen (topic_));
+    assert (rc == 0);
+    rc = zmq_connect (sub, addr_);
+    assert (rc == 0);
+    char buf [64];
+    rc = zmq_recv (pub_, buf, sizeof (buf), 0);
+    assert (rc == (int) strlen (topic_) + 1);
+    assert (buf [0] == 1 && memcmp (buf + 1, topic_, rc - 1) == 0);
+    return sub;
+}
+
+int main (void)
+{
+    fprintf (stderr, "test_xpub_cache running...\n");
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    void *pub = zmq_socket (ctx, ZMQ_XPUB);
+    assert (pub);
+    int verbose = 1;
+    int rc = zmq_setsockopt (pub, ZMQ_XPUB_VERBOSE, &verbose,
+        sizeof (verbose));
+    assert (rc == 0);
+    //  Negative sizes are rejected rather than making the cache unbounded.
+    int cache_size = -1;
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_CACHE_SIZE, &cache_size,
+        sizeof (cache_size));
+    assert (rc == -1 && errno == EINVAL);
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_CACHE_PREFIX, &cache_size,
+        sizeof (cache_size));
+    assert (rc == -1 && errno == EINVAL);
+
+    cache_size = 1000;
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_CACHE_SIZE, &cache_size,
+        sizeof (cache_size));
+    assert (rc == 0);
+    rc = zmq_bind (pub, "inproc://cache");
+    assert (rc == 0);
+
+    //  Nobody is listening yet, but the latest values are kept.
+    publish (pub, "A.1", "old");
+    publish (pub, "A.2", "old");
+    publish (pub, "B.1", "old");
+    publish (pub, "A.1", "new");
+    publish (pub, "A.2", "new");
+    publish (pub, "B.1", "new");
+
+    //  A late subscriber gets the latest value of the matching topics
+    //  straight away, followed by the live updates.
+    void *sub1 = subscribe (ctx, pub, "inproc://cache", "A.");
+    expect (sub1, "A.1", "new");
+    expect (sub1, "A.2", "new");
+    expect_nothing (sub1);
+    publish (pub, "A.2", "live");
+    expect (sub1, "A.2", "live");
+
+    //  Subscribers that came earlier don't get the values again.
+    void *sub2 = subscribe (ctx, pub, "inproc://cache", "B.1");
+    expect (sub2, "B.1", "new");
+    expect_nothing (sub1);
+
+    //  With a smaller limit, the topics not updated for the longest time
+    //  are evicted. Each message takes 3 bytes of topic and 4 of value,
+    //  so only two of them fit.
+    cache_size = 15;
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_CACHE_SIZE, &cache_size,
+        sizeof (cache_size));
+    assert (rc == 0);
+    publish (pub, "C.1", "1111");
+    publish (pub, "C.2", "2222");
+    publish (pub, "C.3", "3333");
+    publish (pub, "C.2", "4444");
+    void *sub3 = subscribe (ctx, pub, "inproc://cache", "");
+    expect (sub3, "C.2", "4444");
+    expect (sub3, "C.3", "3333");
+    expect_nothing (sub3);
+
+    //  Messages larger than the limit are not cached at all.
+    publish (pub, "D.1", "too long to be cached");
+    expect (sub3, "D.1", "too long to be cached");
+    void *sub4 = subscribe (ctx, pub, "inproc://cache", "D");
+    expect_nothing (sub4);
+
+    rc = zmq_close (sub1);
+    assert (rc == 0);
+    rc = zmq_close (sub2);
+    assert (rc == 0);
+    rc = zmq_close (sub3);
+    assert (rc == 0);
+    rc = zmq_close (sub4);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+    rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}
@@ -0,0 +1,235 @@
+/*
+    Copyright (c) 2013 Other contributors as noted in the AUTHORS file
+
+    This file is part of 0MQ.
+
+    0MQ is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by
+    the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    0MQ is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include <stdlib.h>
+
+//  Reads whatever the subscriber gets until nothing arrives for a while.
+//  The publisher is poked in between so that it processes the requests to
+//  resume writing. Returns the number of messages read. latest_ receives
+//  the last value read for each of the 26 topics, -1 if there was none.
+static int drain (void *pub_, void *sub_, bool multipart_, int *latest_)
+{
+    for (int i = 0; i != 26; i++)
+        latest_ [i] = -1;
+
+    int count = 0;
+    int idle = 0;
+    while (idle < 10) {
+        char buf [32];
+        int rc = zmq_recv (sub_, buf, sizeof (buf), ZMQ_DONTWAIT);
+        if (rc == -1) {
+            assert (errno == EAGAIN);
+            int events;
+            size_t size = sizeof (events);
+            rc = zmq_getsockopt (pub_, ZMQ_EVENTS, &events, &size);
+            assert (rc == 0);
+            zmq_pollitem_t item = {sub_, 0, ZMQ_POLLIN, 0};
+            rc = zmq_poll (&item, 1, 10);
+            assert (rc >= 0);
+            idle++;
+            continue;
+        }
+        idle = 0;
+        int topic = buf [0] - 'A';
+        assert (topic >= 0 && topic < 26);
+        if (multipart_) {
+            assert (rc == 1);
+            int more;
+            size_t size = sizeof (more);
+            rc = zmq_getsockopt (sub_, ZMQ_RCVMORE, &more, &size);
+            assert (rc == 0 && more);
+            rc = zmq_recv (sub_, buf, sizeof (buf) - 1, 0);
+            assert (rc > 0);
+            buf [rc] = 0;
+            latest_ [topic] = atoi (buf);
+        }
+        else {
+            assert (rc > 1);
+            buf [rc] = 0;
+            latest_ [topic] = atoi (buf + 1);
+        }
+        count++;
+    }
+    return count;
+}
+
+static void test_conflate (void *ctx_, bool multipart_)
+{
+    void *pub = zmq_socket (ctx_, ZMQ_XPUB);
+    assert (pub);
+    int hwm = 10;
+    int rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int conflate = 1;
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_CONFLATE, &conflate,
+        sizeof (conflate));
+    assert (rc == 0);
+    if (!multipart_) {
+        int prefix = 1;
+        rc = zmq_setsockopt (pub, ZMQ_XPUB_CONFLATE_PREFIX, &prefix,
+            sizeof (prefix));
+        assert (rc == 0);
+    }
+    const char *addr = multipart_ ?
+        "inproc://conflate_multipart" : "inproc://conflate_prefix";
+    rc = zmq_bind (pub, addr);
+    assert (rc == 0);
+
+    void *sub = zmq_socket (ctx_, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    rc = zmq_connect (sub, addr);
+    assert (rc == 0);
+    char subscription [1];
+    rc = zmq_recv (pub, subscription, sizeof (subscription), 0);
+    assert (rc == 1);
+
+    //  Publish far more than the subscriber can queue, cycling through
+    //  five topics.
+    const int count = 10000;
+    for (int i = 0; i != count; i++) {
+        char topic = 'A' + i % 5;
+        char value [16];
+        sprintf (value, "%d", i);
+        if (multipart_) {
+            rc = zmq_send (pub, &topic, 1, ZMQ_SNDMORE);
+            assert (rc == 1);
+            rc = zmq_send (pub, value, strlen (value), 0);
+            assert (rc == (int) strlen (value));
+        }
+        else {
+            char buf [16];
+            buf [0] = topic;
+            memcpy (buf + 1, value, strlen (value));
+            rc = zmq_send (pub, buf, strlen (value) + 1, 0);
+            assert (rc == (int) strlen (value) + 1);
+        }
+    }
+
+    //  The subscriber gets what fitted in the pipe followed by the latest
+    //  value of each topic, not the whole backlog.
+    int latest [26];
+    int received = drain (pub, sub, multipart_, latest);
+    assert (received < 100);
+    for (int i = 0; i != 5; i++)
+        assert (latest [i] == count - 5 + i);
+
+    //  Once caught up, the subscriber gets every message again.
+    for (int i = 0; i != 5; i++) {
+        char buf [8];
+        buf [0] = 'F';
+        if (multipart_) {
+            rc = zmq_send (pub, buf, 1, ZMQ_SNDMORE);
+            assert (rc == 1);
+            rc = zmq_send (pub, "1", 1, 0);
+            assert (rc == 1);
+        }
+        else {
+            buf [1] = '1';
+            rc = zmq_send (pub, buf, 2, 0);
+            assert (rc == 2);
+        }
+    }
+    received = drain (pub, sub, multipart_, latest);
+    assert (received == 5);
+    assert (latest [5] == 1);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+}
+
+static void test_conflate_limit (void *ctx_)
+{
+    void *pub = zmq_socket (ctx_, ZMQ_XPUB);
+    assert (pub);
+    int hwm = 10;
+    int rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    int conflate = 1;
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_CONFLATE, &conflate,
+        sizeof (conflate));
+    assert (rc == 0);
+
+    //  Negative topic sizes are rejected.
+    int prefix = -1;
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_CONFLATE_PREFIX, &prefix,
+        sizeof (prefix));
+    assert (rc == -1 && errno == EINVAL);
+
+    rc = zmq_bind (pub, "inproc://conflate_limit");
+    assert (rc == 0);
+
+    void *sub = zmq_socket (ctx_, ZMQ_SUB);
+    assert (sub);
+    rc = zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm));
+    assert (rc == 0);
+    rc = zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0);
+    assert (rc == 0);
+    rc = zmq_connect (sub, "inproc://conflate_limit");
+    assert (rc == 0);
+    char subscription [1];
+    rc = zmq_recv (pub, subscription, sizeof (subscription), 0);
+    assert (rc == 1);
+
+    //  With the whole message being the topic, every message is a new
+    //  topic. Only as many of them as the pipe can queue are held back,
+    //  the rest is dropped.
+    const int count = 10000;
+    for (int i = 0; i != count; i++) {
+        char buf [16];
+        sprintf (buf, "A%d", i);
+        rc = zmq_send (pub, buf, strlen (buf), 0);
+        assert (rc == (int) strlen (buf));
+    }
+    int latest [26];
+    int received = drain (pub, sub, false, latest);
+    assert (received > 0 && received <= 4 * hwm);
+
+    rc = zmq_close (sub);
+    assert (rc == 0);
+    rc = zmq_close (pub);
+    assert (rc == 0);
+}
+
+int main (void)
+{
+    fprintf (stderr, "test_xpub_conflate running...\n");
+
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    //  Topic and value in separate parts.
+    test_conflate (ctx, true);
+
+    //  Topic being the first byte of a single-part message.
+    test_conflate (ctx, false);
+
+    //  A new topic per message.
+    test_conflate_limit (ctx);
+
+    int rc = zmq_ctx_destroy (ctx);
+    assert (rc == 0);
+    return 0 ;
+}